@@ -32,37 +32,46 @@ struct peripheral_status_state {
     bool connected;
 };
 
-static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 0);
+enum status_element {
+    STATUS_BATTERY = BIT(0),
+    STATUS_CONNECTION = BIT(1),
+};
+
+#define STATUS_ALL (STATUS_BATTERY | STATUS_CONNECTION)
 
+static void draw_connection(lv_obj_t *canvas, const struct status_state *state) {
     lv_draw_label_dsc_t label_dsc;
     init_label_dsc(&label_dsc, LVGL_FOREGROUND, &lv_font_montserrat_16, LV_TEXT_ALIGN_RIGHT);
-    lv_draw_rect_dsc_t rect_black_dsc;
-    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
-
-    // Fill background
-    lv_canvas_draw_rect(canvas, 0, 0, CANVAS_SIZE, CANVAS_SIZE, &rect_black_dsc);
-
-    // Draw battery
-    draw_battery(canvas, state);
 
-    // Draw output status
     lv_canvas_draw_text(canvas, 0, 0, CANVAS_SIZE, &label_dsc,
                         state->connected ? LV_SYMBOL_WIFI : LV_SYMBOL_CLOSE);
+}
+
+static const struct status_region regions[] = {
+    {.element = STATUS_BATTERY, .canvas = 0, .area = {0, 0, 33, 20}, .draw = draw_battery},
+    {.element = STATUS_CONNECTION, .canvas = 0, .area = {34, 0, 67, 20}, .draw = draw_connection},
+};
 
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
+static void draw_dirty(struct zmk_widget_status *widget) {
+    draw_status_regions(widget->obj, regions, ARRAY_SIZE(regions), widget->dirty, &widget->state);
+    widget->dirty = 0;
 }
 
 static void set_battery_status(struct zmk_widget_status *widget,
                                struct battery_status_state state) {
 #if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
-    widget->state.charging = state.usb_present;
+    if (widget->state.charging != state.usb_present) {
+        widget->state.charging = state.usb_present;
+        widget->dirty |= STATUS_BATTERY;
+    }
 #endif /* IS_ENABLED(CONFIG_USB_DEVICE_STACK) */
 
-    widget->state.battery = state.level;
+    if (widget->state.battery != state.level) {
+        widget->state.battery = state.level;
+        widget->dirty |= STATUS_BATTERY;
+    }
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    draw_dirty(widget);
 }
 
 static void battery_status_update_cb(struct battery_status_state state) {
@@ -93,9 +102,12 @@ static struct peripheral_status_state get_state(const zmk_event_t *_eh) {
 
 static void set_connection_status(struct zmk_widget_status *widget,
                                   struct peripheral_status_state state) {
-    widget->state.connected = state.connected;
+    if (widget->state.connected != state.connected) {
+        widget->state.connected = state.connected;
+        widget->dirty |= STATUS_CONNECTION;
+    }
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    draw_dirty(widget);
 }
 
 static void output_status_update_cb(struct peripheral_status_state state) {
@@ -113,12 +125,17 @@ int zmk_widget_status_init(struct zmk_widget_status *widget, lv_obj_t *parent) {
     lv_obj_t *top = lv_canvas_create(widget->obj);
     lv_obj_align(top, LV_ALIGN_TOP_RIGHT, 0, 0);
     lv_canvas_set_buffer(top, widget->cbuf, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
+    // The regions only cover the top of the canvas, so clear the rest once here.
+    lv_canvas_fill_bg(top, LVGL_BACKGROUND, LV_OPA_COVER);
 
     lv_obj_t *art = lv_img_create(widget->obj);
     bool random = sys_rand32_get() & 1;
     lv_img_set_src(art, random ? &balloon : &mountain);
     lv_obj_align(art, LV_ALIGN_TOP_LEFT, 0, 0);
 
+    // Draw everything the first time, even where the state matches the zeroed defaults.
+    widget->dirty = STATUS_ALL;
+
     sys_slist_append(&widgets, &widget->node);
     widget_battery_status_init();
     widget_peripheral_status_init();
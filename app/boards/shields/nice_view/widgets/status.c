@@ -44,27 +44,20 @@ struct wpm_status_state {
     uint8_t wpm;
 };
 
-static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 0);
+enum status_element {
+    STATUS_BATTERY = BIT(0),
+    STATUS_OUTPUT = BIT(1),
+    STATUS_WPM = BIT(2),
+    STATUS_PROFILES = BIT(3),
+    STATUS_LAYER = BIT(4),
+};
+
+#define STATUS_ALL (STATUS_BATTERY | STATUS_OUTPUT | STATUS_WPM | STATUS_PROFILES | STATUS_LAYER)
 
+static void draw_output(lv_obj_t *canvas, const struct status_state *state) {
     lv_draw_label_dsc_t label_dsc;
     init_label_dsc(&label_dsc, LVGL_FOREGROUND, &lv_font_montserrat_16, LV_TEXT_ALIGN_RIGHT);
-    lv_draw_label_dsc_t label_dsc_wpm;
-    init_label_dsc(&label_dsc_wpm, LVGL_FOREGROUND, &lv_font_unscii_8, LV_TEXT_ALIGN_RIGHT);
-    lv_draw_rect_dsc_t rect_black_dsc;
-    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
-    lv_draw_rect_dsc_t rect_white_dsc;
-    init_rect_dsc(&rect_white_dsc, LVGL_FOREGROUND);
-    lv_draw_line_dsc_t line_dsc;
-    init_line_dsc(&line_dsc, LVGL_FOREGROUND, 1);
-
-    // Fill background
-    lv_canvas_draw_rect(canvas, 0, 0, CANVAS_SIZE, CANVAS_SIZE, &rect_black_dsc);
-
-    // Draw battery
-    draw_battery(canvas, state);
 
-    // Draw output status
     char output_text[10] = {};
 
     switch (state->selected_endpoint.transport) {
@@ -85,8 +78,18 @@ static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_st
     }
 
     lv_canvas_draw_text(canvas, 0, 0, CANVAS_SIZE, &label_dsc, output_text);
+}
+
+static void draw_wpm(lv_obj_t *canvas, const struct status_state *state) {
+    lv_draw_label_dsc_t label_dsc_wpm;
+    init_label_dsc(&label_dsc_wpm, LVGL_FOREGROUND, &lv_font_unscii_8, LV_TEXT_ALIGN_RIGHT);
+    lv_draw_rect_dsc_t rect_black_dsc;
+    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
+    lv_draw_rect_dsc_t rect_white_dsc;
+    init_rect_dsc(&rect_white_dsc, LVGL_FOREGROUND);
+    lv_draw_line_dsc_t line_dsc;
+    init_line_dsc(&line_dsc, LVGL_FOREGROUND, 1);
 
-    // Draw WPM
     lv_canvas_draw_rect(canvas, 0, 21, 68, 42, &rect_white_dsc);
     lv_canvas_draw_rect(canvas, 1, 22, 66, 40, &rect_black_dsc);
 
@@ -117,18 +120,9 @@ static void draw_top(lv_obj_t *widget, lv_color_t cbuf[], const struct status_st
         points[i].y = 60 - (state->wpm[i] - min) * 36 / range;
     }
     lv_canvas_draw_line(canvas, points, 10, &line_dsc);
-
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
 }
 
-static void draw_middle(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 1);
-
-    lv_draw_rect_dsc_t rect_black_dsc;
-    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
-    lv_draw_rect_dsc_t rect_white_dsc;
-    init_rect_dsc(&rect_white_dsc, LVGL_FOREGROUND);
+static void draw_profiles(lv_obj_t *canvas, const struct status_state *state) {
     lv_draw_arc_dsc_t arc_dsc;
     init_arc_dsc(&arc_dsc, LVGL_FOREGROUND, 2);
     lv_draw_arc_dsc_t arc_dsc_filled;
@@ -138,9 +132,6 @@ static void draw_middle(lv_obj_t *widget, lv_color_t cbuf[], const struct status
     lv_draw_label_dsc_t label_dsc_black;
     init_label_dsc(&label_dsc_black, LVGL_BACKGROUND, &lv_font_montserrat_18, LV_TEXT_ALIGN_CENTER);
 
-    // Fill background
-    lv_canvas_draw_rect(canvas, 0, 0, CANVAS_SIZE, CANVAS_SIZE, &rect_black_dsc);
-
     // Draw circles
     int circle_offsets[5][2] = {
         {13, 13}, {55, 13}, {34, 34}, {13, 55}, {55, 55},
@@ -162,23 +153,12 @@ static void draw_middle(lv_obj_t *widget, lv_color_t cbuf[], const struct status
         lv_canvas_draw_text(canvas, circle_offsets[i][0] - 8, circle_offsets[i][1] - 10, 16,
                             (selected ? &label_dsc_black : &label_dsc), label);
     }
-
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
 }
 
-static void draw_bottom(lv_obj_t *widget, lv_color_t cbuf[], const struct status_state *state) {
-    lv_obj_t *canvas = lv_obj_get_child(widget, 2);
-
-    lv_draw_rect_dsc_t rect_black_dsc;
-    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
+static void draw_layer(lv_obj_t *canvas, const struct status_state *state) {
     lv_draw_label_dsc_t label_dsc;
     init_label_dsc(&label_dsc, LVGL_FOREGROUND, &lv_font_montserrat_14, LV_TEXT_ALIGN_CENTER);
 
-    // Fill background
-    lv_canvas_draw_rect(canvas, 0, 0, CANVAS_SIZE, CANVAS_SIZE, &rect_black_dsc);
-
-    // Draw layer
     if (state->layer_label == NULL) {
         char text[10] = {};
 
@@ -188,20 +168,40 @@ static void draw_bottom(lv_obj_t *widget, lv_color_t cbuf[], const struct status
     } else {
         lv_canvas_draw_text(canvas, 0, 5, 68, &label_dsc, state->layer_label);
     }
+}
 
-    // Rotate canvas
-    rotate_canvas(canvas, cbuf);
+/*
+ * The top canvas holds the battery, output and WPM regions, the middle one the profiles and the
+ * bottom one the layer. Regions on a canvas must not overlap.
+ */
+static const struct status_region regions[] = {
+    {.element = STATUS_BATTERY, .canvas = 0, .area = {0, 0, 33, 20}, .draw = draw_battery},
+    {.element = STATUS_OUTPUT, .canvas = 0, .area = {34, 0, 67, 20}, .draw = draw_output},
+    {.element = STATUS_WPM, .canvas = 0, .area = {0, 21, 67, 67}, .draw = draw_wpm},
+    {.element = STATUS_PROFILES, .canvas = 1, .area = {0, 0, 67, 67}, .draw = draw_profiles},
+    {.element = STATUS_LAYER, .canvas = 2, .area = {0, 0, 67, 67}, .draw = draw_layer},
+};
+
+static void draw_dirty(struct zmk_widget_status *widget) {
+    draw_status_regions(widget->obj, regions, ARRAY_SIZE(regions), widget->dirty, &widget->state);
+    widget->dirty = 0;
 }
 
 static void set_battery_status(struct zmk_widget_status *widget,
                                struct battery_status_state state) {
 #if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
-    widget->state.charging = state.usb_present;
+    if (widget->state.charging != state.usb_present) {
+        widget->state.charging = state.usb_present;
+        widget->dirty |= STATUS_BATTERY;
+    }
 #endif /* IS_ENABLED(CONFIG_USB_DEVICE_STACK) */
 
-    widget->state.battery = state.level;
+    if (widget->state.battery != state.level) {
+        widget->state.battery = state.level;
+        widget->dirty |= STATUS_BATTERY;
+    }
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    draw_dirty(widget);
 }
 
 static void battery_status_update_cb(struct battery_status_state state) {
@@ -230,13 +230,21 @@ ZMK_SUBSCRIPTION(widget_battery_status, zmk_usb_conn_state_changed);
 
 static void set_output_status(struct zmk_widget_status *widget,
                               const struct output_status_state *state) {
-    widget->state.selected_endpoint = state->selected_endpoint;
-    widget->state.active_profile_index = state->active_profile_index;
-    widget->state.active_profile_connected = state->active_profile_connected;
-    widget->state.active_profile_bonded = state->active_profile_bonded;
+    if (!zmk_endpoint_instance_eq(widget->state.selected_endpoint, state->selected_endpoint) ||
+        widget->state.active_profile_connected != state->active_profile_connected ||
+        widget->state.active_profile_bonded != state->active_profile_bonded) {
+        widget->state.selected_endpoint = state->selected_endpoint;
+        widget->state.active_profile_connected = state->active_profile_connected;
+        widget->state.active_profile_bonded = state->active_profile_bonded;
+        widget->dirty |= STATUS_OUTPUT;
+    }
+
+    if (widget->state.active_profile_index != state->active_profile_index) {
+        widget->state.active_profile_index = state->active_profile_index;
+        widget->dirty |= STATUS_PROFILES;
+    }
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
-    draw_middle(widget->obj, widget->cbuf2, &widget->state);
+    draw_dirty(widget);
 }
 
 static void output_status_update_cb(struct output_status_state state) {
@@ -247,9 +255,11 @@ static void output_status_update_cb(struct output_status_state state) {
 static struct output_status_state output_status_get_state(const zmk_event_t *_eh) {
     return (struct output_status_state){
         .selected_endpoint = zmk_endpoints_selected(),
+#if IS_ENABLED(CONFIG_ZMK_BLE)
         .active_profile_index = zmk_ble_active_profile_index(),
         .active_profile_connected = zmk_ble_active_profile_is_connected(),
         .active_profile_bonded = !zmk_ble_active_profile_is_open(),
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
     };
 }
 
@@ -265,10 +275,13 @@ ZMK_SUBSCRIPTION(widget_output_status, zmk_ble_active_profile_changed);
 #endif
 
 static void set_layer_status(struct zmk_widget_status *widget, struct layer_status_state state) {
-    widget->state.layer_index = state.index;
-    widget->state.layer_label = state.label;
+    if (widget->state.layer_index != state.index || widget->state.layer_label != state.label) {
+        widget->state.layer_index = state.index;
+        widget->state.layer_label = state.label;
+        widget->dirty |= STATUS_LAYER;
+    }
 
-    draw_bottom(widget->obj, widget->cbuf3, &widget->state);
+    draw_dirty(widget);
 }
 
 static void layer_status_update_cb(struct layer_status_state state) {
@@ -291,8 +304,9 @@ static void set_wpm_status(struct zmk_widget_status *widget, struct wpm_status_s
         widget->state.wpm[i] = widget->state.wpm[i + 1];
     }
     widget->state.wpm[9] = state.wpm;
+    widget->dirty |= STATUS_WPM;
 
-    draw_top(widget->obj, widget->cbuf, &widget->state);
+    draw_dirty(widget);
 }
 
 static void wpm_status_update_cb(struct wpm_status_state state) {
@@ -321,6 +335,9 @@ int zmk_widget_status_init(struct zmk_widget_status *widget, lv_obj_t *parent) {
     lv_obj_align(bottom, LV_ALIGN_TOP_LEFT, -44, 0);
     lv_canvas_set_buffer(bottom, widget->cbuf3, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
 
+    // Draw everything the first time, even where the state matches the zeroed defaults.
+    widget->dirty = STATUS_ALL;
+
     sys_slist_append(&widgets, &widget->node);
     widget_battery_status_init();
     widget_output_status_init();
@@ -18,6 +18,8 @@ struct zmk_widget_status {
     lv_color_t cbuf2[CANVAS_SIZE * CANVAS_SIZE];
     lv_color_t cbuf3[CANVAS_SIZE * CANVAS_SIZE];
     struct status_state state;
+    /* Elements whose state changed since they were last drawn. */
+    uint8_t dirty;
 };
 
 int zmk_widget_status_init(struct zmk_widget_status *widget, lv_obj_t *parent);
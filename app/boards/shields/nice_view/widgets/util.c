@@ -10,18 +10,68 @@
 
 LV_IMG_DECLARE(bolt);
 
-void rotate_canvas(lv_obj_t *canvas, lv_color_t cbuf[]) {
-    static lv_color_t cbuf_tmp[CANVAS_SIZE * CANVAS_SIZE];
-    memcpy(cbuf_tmp, cbuf, sizeof(cbuf_tmp));
-    lv_img_dsc_t img;
-    img.data = (void *)cbuf_tmp;
-    img.header.cf = LV_IMG_CF_TRUE_COLOR;
-    img.header.w = CANVAS_SIZE;
-    img.header.h = CANVAS_SIZE;
-
-    lv_canvas_fill_bg(canvas, LVGL_BACKGROUND, LV_OPA_COVER);
-    lv_canvas_transform(canvas, &img, 900, LV_IMG_ZOOM_NONE, -1, 0, CANVAS_SIZE / 2,
-                        CANVAS_SIZE / 2, true);
+/* Unrotated drawing surface. It is shared, as canvases are drawn one region at a time. */
+static lv_color_t scratch_buf[CANVAS_SIZE * CANVAS_SIZE];
+static lv_obj_t *scratch;
+
+static lv_obj_t *get_scratch_canvas(void) {
+    if (scratch == NULL) {
+        // Without a parent, the canvas is a screen of its own, which is never loaded or rendered.
+        scratch = lv_canvas_create(NULL);
+        lv_canvas_set_buffer(scratch, scratch_buf, CANVAS_SIZE, CANVAS_SIZE, LV_IMG_CF_TRUE_COLOR);
+    }
+
+    return scratch;
+}
+
+/**
+ * Copy an area of the scratch canvas onto a widget canvas, rotated 90 degrees clockwise, and
+ * invalidate only the part of the screen it covers.
+ */
+static void rotate_area(lv_obj_t *canvas, const lv_area_t *area) {
+    lv_color_t *cbuf = (lv_color_t *)lv_canvas_get_img(canvas)->data;
+
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        for (lv_coord_t x = area->x1; x <= area->x2; x++) {
+            cbuf[x * CANVAS_SIZE + CANVAS_SIZE - 1 - y] = scratch_buf[y * CANVAS_SIZE + x];
+        }
+    }
+
+    lv_area_t coords;
+    lv_obj_get_coords(canvas, &coords);
+
+    lv_area_t rotated = {
+        .x1 = CANVAS_SIZE - 1 - area->y2,
+        .y1 = area->x1,
+        .x2 = CANVAS_SIZE - 1 - area->y1,
+        .y2 = area->x2,
+    };
+    lv_area_move(&rotated, coords.x1, coords.y1);
+    lv_obj_invalidate_area(canvas, &rotated);
+}
+
+void draw_status_regions(lv_obj_t *widget, const struct status_region regions[], size_t count,
+                         uint8_t dirty, const struct status_state *state) {
+    lv_obj_t *canvas = get_scratch_canvas();
+
+    lv_draw_rect_dsc_t rect_black_dsc;
+    init_rect_dsc(&rect_black_dsc, LVGL_BACKGROUND);
+
+    for (size_t i = 0; i < count; i++) {
+        const struct status_region *region = &regions[i];
+        const lv_area_t *area = &region->area;
+
+        if (!(dirty & region->element)) {
+            continue;
+        }
+
+        // Clear the region first, as elements draw over whatever is already there.
+        lv_canvas_draw_rect(canvas, area->x1, area->y1, lv_area_get_width(area),
+                            lv_area_get_height(area), &rect_black_dsc);
+        region->draw(canvas, state);
+
+        rotate_area(lv_obj_get_child(widget, region->canvas), area);
+    }
 }
 
 void draw_battery(lv_obj_t *canvas, const struct status_state *state) {
@@ -38,7 +38,21 @@ struct battery_status_state {
 #endif
 };
 
-void rotate_canvas(lv_obj_t *canvas, lv_color_t cbuf[]);
+/**
+ * Part of a widget canvas that is redrawn on its own when the state it shows changes.
+ */
+struct status_region {
+    /* Bit in the widget's dirty mask that marks this region for redrawing. */
+    uint8_t element;
+    /* Index of the canvas among the widget's children. */
+    uint8_t canvas;
+    /* Inclusive bounds on the canvas before it is rotated onto the screen. */
+    lv_area_t area;
+    void (*draw)(lv_obj_t *canvas, const struct status_state *state);
+};
+
+void draw_status_regions(lv_obj_t *widget, const struct status_region regions[], size_t count,
+                         uint8_t dirty, const struct status_state *state);
 void draw_battery(lv_obj_t *canvas, const struct status_state *state);
 void init_label_dsc(lv_draw_label_dsc_t *label_dsc, lv_color_t color, const lv_font_t *font,
                     lv_text_align_t align);
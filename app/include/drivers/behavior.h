@@ -58,6 +58,16 @@ __subsystem struct behavior_driver_api {
 
 struct zmk_behavior_ref {
     const struct device *device;
+    zmk_behavior_local_id_t local_id;
+};
+
+/**
+ * One slot per behavior, filled at boot with the behaviors sorted by local ID so they can be
+ * looked up with a binary search.
+ */
+struct zmk_behavior_local_id_map {
+    const struct device *device;
+    zmk_behavior_local_id_t local_id;
 };
 
 /**
@@ -67,7 +77,11 @@ struct zmk_behavior_ref {
     static const STRUCT_SECTION_ITERABLE(zmk_behavior_ref,                                         \
                                          _CONCAT(zmk_behavior_, DEVICE_DT_NAME_GET(node_id))) = {  \
         .device = DEVICE_DT_GET(node_id),                                                          \
-    }
+        .local_id = ZMK_BEHAVIOR_LOCAL_ID(node_id),                                                \
+    };                                                                                             \
+    static STRUCT_SECTION_ITERABLE(zmk_behavior_local_id_map,                                      \
+                                   _CONCAT(zmk_behavior_local_id_map_,                             \
+                                           DEVICE_DT_NAME_GET(node_id)))
 
 /**
  * @brief Like DEVICE_DT_DEFINE(), but also registers the device as a behavior.
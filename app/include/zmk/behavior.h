@@ -11,6 +11,15 @@
 #define ZMK_BEHAVIOR_OPAQUE 0
 #define ZMK_BEHAVIOR_TRANSPARENT 1
 
+/**
+ * A compact identifier for a behavior, stable for a given firmware build. It is the devicetree
+ * dependency ordinal of the behavior node, so it can be computed at compile time.
+ */
+typedef uint16_t zmk_behavior_local_id_t;
+
+#define ZMK_BEHAVIOR_LOCAL_ID(node_id) ((zmk_behavior_local_id_t)DT_DEP_ORD(node_id))
+#define ZMK_BEHAVIOR_LOCAL_ID_NONE UINT16_MAX
+
 struct zmk_behavior_binding {
     char *behavior_dev;
     uint32_t param1;
@@ -36,3 +45,29 @@ struct zmk_behavior_binding_event {
  * unrelated node which shares the same name as a behavior.
  */
 const struct device *zmk_behavior_get_binding(const char *name);
+
+/**
+ * @brief Get the name of the behavior with the given local ID.
+ *
+ * @retval The name of the behavior, suitable for use as zmk_behavior_binding.behavior_dev.
+ * @retval NULL if no behavior has the given local ID.
+ */
+const char *zmk_behavior_find_behavior_name_from_local_id(zmk_behavior_local_id_t local_id);
+
+/**
+ * @brief Get the behavior device with the given local ID.
+ *
+ * @retval Pointer to the device structure for the behavior.
+ * @retval NULL if no behavior has the given local ID or its initialization function failed.
+ *
+ * @note Unlike looking the behavior up by name, this is a binary search, so it is cheap enough
+ * for the key press path.
+ */
+const struct device *zmk_behavior_get_device_from_local_id(zmk_behavior_local_id_t local_id);
+
+/**
+ * @brief Get the local ID of the behavior with the given name.
+ *
+ * @retval ZMK_BEHAVIOR_LOCAL_ID_NONE if the behavior is not found.
+ */
+zmk_behavior_local_id_t zmk_behavior_get_local_id(const char *name);
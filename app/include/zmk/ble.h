@@ -32,6 +32,7 @@ int zmk_ble_profile_index(const bt_addr_le_t *addr);
 bt_addr_le_t *zmk_ble_active_profile_addr(void);
 bool zmk_ble_active_profile_is_open(void);
 bool zmk_ble_active_profile_is_connected(void);
+uint32_t zmk_ble_active_profile_interval_us(void);
 char *zmk_ble_active_profile_name(void);
 int8_t zmk_ble_profile_status(uint8_t index);
 
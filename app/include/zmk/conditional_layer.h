@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2021 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zmk/keymap.h>
+
+/**
+ * Apply every configured conditional layer to the given layer state until it stops changing, and
+ * return the resulting state. With no conditional layers configured, the state is returned as-is.
+ */
+zmk_keymap_layers_state_t zmk_conditional_layer_resolve(zmk_keymap_layers_state_t state);
@@ -15,6 +15,15 @@ struct k_work_q *zmk_display_work_q(void);
 bool zmk_display_is_initialized(void);
 int zmk_display_init(void);
 
+/**
+ * @brief Schedule LVGL to draw the status screen after a widget has changed. Calls made within a
+ * few milliseconds of each other are drawn together, and nothing is drawn while the display is
+ * blanked. Widgets defined with ZMK_DISPLAY_WIDGET_LISTENER call this after every update. Widgets
+ * that change LVGL objects from their own listener, work item or timer should call it too;
+ * otherwise the change is only drawn on the next idle tick (CONFIG_ZMK_DISPLAY_IDLE_TICK_MS).
+ **/
+void zmk_display_invalidate(void);
+
 /**
  * @brief Macro to define a ZMK event listener that handles the thread safety of fetching
  * the necessary state from the system work queue context, invoking a work callback
@@ -39,7 +48,10 @@ int zmk_display_init(void);
         k_mutex_unlock(&listener##_mutex);                                                         \
         return copy;                                                                               \
     };                                                                                             \
-    static void listener##_work_cb(struct k_work *work) { cb(listener##_get_local_state()); };     \
+    static void listener##_work_cb(struct k_work *work) {                                          \
+        cb(listener##_get_local_state());                                                          \
+        zmk_display_invalidate();                                                                  \
+    };                                                                                             \
     K_WORK_DEFINE(listener##_work, listener##_work_cb);                                            \
     static void listener##_refresh_state(const zmk_event_t *eh) {                                  \
         k_mutex_lock(&listener##_mutex, K_FOREVER);                                                \
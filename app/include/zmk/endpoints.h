@@ -74,4 +74,10 @@ int zmk_endpoints_send_report(uint16_t usage_page);
 
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
 int zmk_endpoints_send_mouse_report();
+
+/**
+ * Gets the minimum time between mouse reports the selected endpoint can deliver, in
+ * microseconds, or 0 if it is not known.
+ */
+uint32_t zmk_endpoints_mouse_report_interval_us(void);
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
@@ -8,16 +8,30 @@
 
 #include <zephyr/kernel.h>
 #include <zmk/event_manager.h>
+#include <zmk/keymap.h>
 
+// Raised once per layer transition, however many layers it touched.
 struct zmk_layer_state_changed {
+    // Highest layer that changed in this transition, and its new state.
     uint8_t layer;
     bool state;
+    // Full layer state after the transition, and the layers whose state differs from before it.
+    zmk_keymap_layers_state_t layers;
+    zmk_keymap_layers_state_t changed;
     int64_t timestamp;
 };
 
 ZMK_EVENT_DECLARE(zmk_layer_state_changed);
 
-static inline int raise_layer_state_changed(uint8_t layer, bool state) {
+static inline int raise_layer_state_changed(zmk_keymap_layers_state_t old_state,
+                                            zmk_keymap_layers_state_t new_state) {
+    zmk_keymap_layers_state_t changed = old_state ^ new_state;
+    uint8_t layer = MAX(zmk_keymap_layers_highest(changed), 0);
+
     return raise_zmk_layer_state_changed((struct zmk_layer_state_changed){
-        .layer = layer, .state = state, .timestamp = k_uptime_get()});
+        .layer = layer,
+        .state = (new_state & ZMK_KEYMAP_LAYER_BIT(layer)) != 0,
+        .layers = new_state,
+        .changed = changed,
+        .timestamp = k_uptime_get()});
 }
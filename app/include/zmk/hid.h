@@ -13,6 +13,9 @@
 #if IS_ENABLED(CONFIG_ZMK_MOUSE)
 #include <zmk/mouse.h>
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+#include <zmk/keymap_update.h>
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
 
 #include <dt-bindings/zmk/hid_usage.h>
 #include <dt-bindings/zmk/hid_usage_pages.h>
@@ -25,6 +28,9 @@
 
 #define ZMK_HID_MOUSE_NUM_BUTTONS 0x05
 
+// Largest movement, scroll or pan in one mouse report, matching the descriptor's logical range.
+#define ZMK_HID_MOUSE_DELTA_MAX 0x7F
+
 // See https://www.usb.org/sites/default/files/hid1_11.pdf section 6.2.2.4 Main Items
 
 #define ZMK_HID_MAIN_VAL_DATA (0x00 << 0)
@@ -58,6 +64,9 @@
 #define ZMK_HID_REPORT_ID_LEDS 0x01
 #define ZMK_HID_REPORT_ID_CONSUMER 0x02
 #define ZMK_HID_REPORT_ID_MOUSE 0x03
+#define ZMK_HID_REPORT_ID_KEYMAP_UPDATE 0x04
+
+#define ZMK_HID_USAGE_PAGE_VENDOR 0xFF00
 
 // Needed until Zephyr offers a 2 byte usage macro
 #define HID_USAGE16(idx)                                                                           \
@@ -186,6 +195,22 @@ static const uint8_t zmk_hid_report_desc[] = {
     HID_END_COLLECTION,
     HID_END_COLLECTION,
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+    HID_ITEM(HID_ITEM_TAG_USAGE_PAGE, HID_ITEM_TYPE_GLOBAL, 2),
+    (ZMK_HID_USAGE_PAGE_VENDOR & 0xFF),
+    (ZMK_HID_USAGE_PAGE_VENDOR >> 8 & 0xFF),
+    HID_USAGE(0x01),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_REPORT_ID(ZMK_HID_REPORT_ID_KEYMAP_UPDATE),
+    HID_USAGE(0x01),
+    HID_LOGICAL_MIN8(0x00),
+    HID_LOGICAL_MAX16(0xFF, 0x00),
+    HID_REPORT_SIZE(0x08),
+    HID_REPORT_COUNT(ZMK_KEYMAP_UPDATE_MAX_LEN - 1),
+    HID_OUTPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_ARRAY | ZMK_HID_MAIN_VAL_ABS),
+    HID_END_COLLECTION,
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
 };
 
 #if IS_ENABLED(CONFIG_ZMK_USB_BOOT)
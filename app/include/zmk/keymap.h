@@ -6,13 +6,72 @@
 
 #pragma once
 
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/math_extras.h>
+
+#include <zmk/behavior.h>
 #include <zmk/events/position_state_changed.h>
 
 #define ZMK_LAYER_CHILD_LEN_PLUS_ONE(node) 1 +
 #define ZMK_KEYMAP_LAYERS_LEN                                                                      \
     (DT_FOREACH_CHILD(DT_INST(0, zmk_keymap), ZMK_LAYER_CHILD_LEN_PLUS_ONE) 0)
 
+// The layer state is a single bitmask, so every set operation on it is one (or, for keymaps with
+// more than 32 layers, two) machine word operations. The width follows the number of layers.
+#if DT_HAS_COMPAT_STATUS_OKAY(zmk_keymap)
+#if ZMK_KEYMAP_LAYERS_LEN > 32
+#define ZMK_KEYMAP_LAYERS_STATE_BITS 64
+#endif
+#endif
+
+#ifndef ZMK_KEYMAP_LAYERS_STATE_BITS
+#define ZMK_KEYMAP_LAYERS_STATE_BITS 32
+#endif
+
+#if ZMK_KEYMAP_LAYERS_STATE_BITS == 64
+typedef uint64_t zmk_keymap_layers_state_t;
+#else
 typedef uint32_t zmk_keymap_layers_state_t;
+#endif
+
+#define ZMK_KEYMAP_LAYER_BIT(layer) (((zmk_keymap_layers_state_t)1) << (layer))
+
+// Highest layer set in the given state, or -1 if no layer is set.
+static inline int zmk_keymap_layers_highest(zmk_keymap_layers_state_t state) {
+    if (state == 0) {
+        return -1;
+    }
+#if ZMK_KEYMAP_LAYERS_STATE_BITS == 64
+    return 63 - u64_count_leading_zeros(state);
+#else
+    return 31 - u32_count_leading_zeros(state);
+#endif
+}
+
+// Lowest layer set in the given state, or -1 if no layer is set.
+static inline int zmk_keymap_layers_lowest(zmk_keymap_layers_state_t state) {
+    if (state == 0) {
+        return -1;
+    }
+#if ZMK_KEYMAP_LAYERS_STATE_BITS == 64
+    return u64_count_trailing_zeros(state);
+#else
+    return u32_count_trailing_zeros(state);
+#endif
+}
+
+// Visits only the layers set in state, from highest to lowest. The state expression is evaluated
+// once, before the first iteration.
+#define ZMK_KEYMAP_LAYERS_FOREACH_DESC(layer, state)                                               \
+    for (zmk_keymap_layers_state_t _zmk_layers_left = (state);                                     \
+         _zmk_layers_left != 0 && ((layer) = zmk_keymap_layers_highest(_zmk_layers_left), 1);      \
+         _zmk_layers_left &= ~ZMK_KEYMAP_LAYER_BIT(layer))
+
+// Visits only the layers set in state, from lowest to highest.
+#define ZMK_KEYMAP_LAYERS_FOREACH(layer, state)                                                    \
+    for (zmk_keymap_layers_state_t _zmk_layers_left = (state);                                     \
+         _zmk_layers_left != 0 && ((layer) = zmk_keymap_layers_lowest(_zmk_layers_left), 1);       \
+         _zmk_layers_left &= _zmk_layers_left - 1)
 
 uint8_t zmk_keymap_layer_default(void);
 zmk_keymap_layers_state_t zmk_keymap_layer_state(void);
@@ -22,8 +81,49 @@ int zmk_keymap_layer_activate(uint8_t layer);
 int zmk_keymap_layer_deactivate(uint8_t layer);
 int zmk_keymap_layer_toggle(uint8_t layer);
 int zmk_keymap_layer_to(uint8_t layer);
+/**
+ * Replace the whole layer state in a single transition. Conditional layers are resolved before the
+ * new state is applied, and a single zmk_layer_state_changed event is raised for the transition.
+ */
+int zmk_keymap_layer_state_set(zmk_keymap_layers_state_t state);
 const char *zmk_keymap_layer_name(uint8_t layer);
 
+/**
+ * Get the binding currently assigned to a key position on a layer, including any change made at
+ * runtime with zmk_keymap_set_binding().
+ */
+int zmk_keymap_get_binding(uint8_t layer, uint32_t position, struct zmk_behavior_binding *binding);
+
+/**
+ * Change the binding of a key position on a layer until the next reboot. Setting a position back
+ * to its devicetree binding removes the change.
+ *
+ * @retval -ENOMEM if CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES positions are already changed.
+ * @retval -ENODEV if the binding's behavior does not exist.
+ * @retval -EBUSY if the position is held, since its release would go to the new binding.
+ */
+int zmk_keymap_set_binding(uint8_t layer, uint32_t position,
+                           const struct zmk_behavior_binding *binding);
+
+/**
+ * Runtime keymap update messages, all multi-byte values little-endian:
+ *
+ *   SET:   0x01, count:u8, then count entries of
+ *          layer:u8, position:u8, param1:u32, param2:u32, name_len:u8, name[name_len]
+ *   RESET: 0x02
+ *
+ * `name` is the behavior's device name, e.g. "key_press" for &kp. Changes take effect
+ * immediately and, with CONFIG_SETTINGS, are saved after CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE.
+ * Bytes after the last SET entry are ignored, so fixed-size transport frames can be padded.
+ * A SET is checked in full before any entry is applied. If one entry is rejected, or the entries
+ * together need more than CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES changed positions, nothing changes.
+ * A position may only appear once in a SET.
+ */
+#define ZMK_KEYMAP_UPDATE_OP_SET 0x01
+#define ZMK_KEYMAP_UPDATE_OP_RESET 0x02
+
+int zmk_keymap_update(const uint8_t *data, size_t len);
+
 int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pressed,
                                       int64_t timestamp);
 
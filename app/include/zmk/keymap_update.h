@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/bluetooth/uuid.h>
+
+#define ZMK_KEYMAP_UPDATE_MAX_LEN 64
+
+#define ZMK_BT_KEYMAP_UPDATE_UUID(num)                                                             \
+    BT_UUID_128_ENCODE(num, 0x4b1d, 0x4a3e, 0x9b6c, 0x0c1f2e3d4a5b)
+#define ZMK_KEYMAP_UPDATE_BT_SERVICE_UUID ZMK_BT_KEYMAP_UPDATE_UUID(0x00000000)
+#define ZMK_KEYMAP_UPDATE_BT_CHAR_UPDATE_UUID ZMK_BT_KEYMAP_UPDATE_UUID(0x00000001)
+
+/**
+ * Queue a keymap update message received by a transport. The message is copied and applied
+ * with zmk_keymap_update() from the system work queue, so this is safe to call from the USB
+ * and Bluetooth stack callbacks.
+ */
+int zmk_keymap_update_submit(const uint8_t *data, size_t len);
@@ -3,6 +3,7 @@
 
 #include <zephyr/bluetooth/addr.h>
 #include <zmk/behavior.h>
+#include <zmk/keymap.h>
 
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 #include <zmk/hid_indicators_types.h>
@@ -23,4 +24,4 @@ int zmk_split_get_peripheral_battery_level(uint8_t source, uint8_t *level);
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
 
-int zmk_split_bt_update_layers(uint32_t layers);
+int zmk_split_bt_update_layers(zmk_keymap_layers_state_t layers);
@@ -1,4 +1,6 @@
 #pragma once
 
-void set_peripheral_layers_state(uint32_t new_layers);
+#include <zmk/keymap.h>
+
+void set_peripheral_layers_state(zmk_keymap_layers_state_t new_layers);
 bool peripheral_layer_active(uint8_t layer);
\ No newline at end of file
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_display_mock
+
+/**
+ * @file Stand-in monochrome display for native_posix.
+ *
+ * Writes are copied into an in-memory framebuffer, one bit per pixel, and logged with their size
+ * and the running totals, for tests of how much of the screen each widget update pushes.
+ */
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/display.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(display_mock, CONFIG_DISPLAY_LOG_LEVEL);
+
+struct display_mock_config {
+    uint16_t width;
+    uint16_t height;
+    bool x_alignment_width;
+};
+
+struct display_mock_data {
+    uint8_t *framebuffer;
+    uint32_t writes;
+    uint32_t pixels;
+};
+
+static int display_mock_write(const struct device *dev, const uint16_t x, const uint16_t y,
+                              const struct display_buffer_descriptor *desc, const void *buf) {
+    const struct display_mock_config *config = dev->config;
+    struct display_mock_data *data = dev->data;
+    const uint8_t *src = buf;
+
+    if (x + desc->width > config->width || y + desc->height > config->height) {
+        return -EINVAL;
+    }
+
+    // Rows are packed eight pixels to a byte, so writes have to start and end on a byte.
+    if (x % 8 != 0 || desc->width % 8 != 0 || desc->pitch % 8 != 0) {
+        return -EINVAL;
+    }
+
+    if (config->x_alignment_width && desc->width != config->width) {
+        return -EINVAL;
+    }
+
+    for (uint16_t row = 0; row < desc->height; row++) {
+        memcpy(&data->framebuffer[((y + row) * config->width + x) / 8],
+               &src[row * desc->pitch / 8], desc->width / 8);
+    }
+
+    data->writes++;
+    data->pixels += desc->width * desc->height;
+
+    LOG_DBG("%s: wrote %ux%u at (%u, %u), %u pixels in %u writes so far", dev->name, desc->width,
+            desc->height, x, y, data->pixels, data->writes);
+
+    return 0;
+}
+
+static int display_mock_read(const struct device *dev, const uint16_t x, const uint16_t y,
+                             const struct display_buffer_descriptor *desc, void *buf) {
+    return -ENOTSUP;
+}
+
+static void *display_mock_get_framebuffer(const struct device *dev) {
+    struct display_mock_data *data = dev->data;
+
+    return data->framebuffer;
+}
+
+static int display_mock_blanking_on(const struct device *dev) { return 0; }
+
+static int display_mock_blanking_off(const struct device *dev) { return 0; }
+
+static int display_mock_set_brightness(const struct device *dev, const uint8_t brightness) {
+    return -ENOTSUP;
+}
+
+static int display_mock_set_contrast(const struct device *dev, const uint8_t contrast) {
+    return -ENOTSUP;
+}
+
+static void display_mock_get_capabilities(const struct device *dev,
+                                          struct display_capabilities *caps) {
+    const struct display_mock_config *config = dev->config;
+
+    memset(caps, 0, sizeof(struct display_capabilities));
+    caps->x_resolution = config->width;
+    caps->y_resolution = config->height;
+    caps->supported_pixel_formats = PIXEL_FORMAT_MONO01;
+    caps->current_pixel_format = PIXEL_FORMAT_MONO01;
+    caps->screen_info = SCREEN_INFO_MONO_MSB_FIRST;
+    if (config->x_alignment_width) {
+        caps->screen_info |= SCREEN_INFO_X_ALIGNMENT_WIDTH;
+    }
+}
+
+static int display_mock_set_pixel_format(const struct device *dev,
+                                         const enum display_pixel_format pf) {
+    return pf == PIXEL_FORMAT_MONO01 ? 0 : -ENOTSUP;
+}
+
+static int display_mock_set_orientation(const struct device *dev,
+                                        const enum display_orientation orientation) {
+    return orientation == DISPLAY_ORIENTATION_NORMAL ? 0 : -ENOTSUP;
+}
+
+static const struct display_driver_api display_mock_api = {
+    .blanking_on = display_mock_blanking_on,
+    .blanking_off = display_mock_blanking_off,
+    .write = display_mock_write,
+    .read = display_mock_read,
+    .get_framebuffer = display_mock_get_framebuffer,
+    .set_brightness = display_mock_set_brightness,
+    .set_contrast = display_mock_set_contrast,
+    .get_capabilities = display_mock_get_capabilities,
+    .set_pixel_format = display_mock_set_pixel_format,
+    .set_orientation = display_mock_set_orientation,
+};
+
+#define DISPLAY_MOCK_INIT(n)                                                                       \
+    BUILD_ASSERT(DT_INST_PROP(n, width) % 8 == 0, "Width must be a multiple of 8");                \
+                                                                                                   \
+    static uint8_t display_mock_framebuffer_##n[DT_INST_PROP(n, width) *                           \
+                                                DT_INST_PROP(n, height) / 8];                      \
+                                                                                                   \
+    static struct display_mock_data display_mock_data_##n = {                                      \
+        .framebuffer = display_mock_framebuffer_##n,                                               \
+    };                                                                                             \
+                                                                                                   \
+    static const struct display_mock_config display_mock_config_##n = {                            \
+        .width = DT_INST_PROP(n, width),                                                           \
+        .height = DT_INST_PROP(n, height),                                                         \
+        .x_alignment_width = DT_INST_PROP(n, x_alignment_width),                                   \
+    };                                                                                             \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, NULL, NULL, &display_mock_data_##n, &display_mock_config_##n,         \
+                          POST_KERNEL, CONFIG_DISPLAY_INIT_PRIORITY, &display_mock_api);
+
+DT_INST_FOREACH_STATUS_OKAY(DISPLAY_MOCK_INIT)
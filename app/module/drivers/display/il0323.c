@@ -14,6 +14,8 @@
 #include <zephyr/drivers/spi.h>
 #include <zephyr/sys/byteorder.h>
 
+#include <zmk/display.h>
+
 #include "il0323_regs.h"
 
 #include <zephyr/logging/log.h>
@@ -34,7 +36,7 @@ LOG_MODULE_REGISTER(il0323, CONFIG_DISPLAY_LOG_LEVEL);
 #define IL0323_PANEL_LAST_GATE (EPD_PANEL_HEIGHT - 1)
 #define IL0323_PANEL_FIRST_PAGE 0U
 #define IL0323_PANEL_LAST_PAGE (IL0323_NUMOF_PAGES - 1)
-#define IL0323_BUFFER_SIZE 1280
+#define IL0323_BUFFER_SIZE (IL0323_NUMOF_PAGES * EPD_PANEL_HEIGHT)
 
 struct il0323_cfg {
     struct gpio_dt_spec reset;
@@ -43,12 +45,49 @@ struct il0323_cfg {
     struct spi_dt_spec spi;
 };
 
+/* Inclusive pixel bounds of a region of the panel. x bounds are whole pages. */
+struct il0323_window {
+    uint16_t x_start;
+    uint16_t x_end;
+    uint16_t y_start;
+    uint16_t y_end;
+};
+
 static uint8_t il0323_pwr[] = DT_INST_PROP(0, pwr);
 
+/* What the panel shows, which the controller needs as old data for each refresh. */
 static uint8_t last_buffer[IL0323_BUFFER_SIZE];
+/* What has been written to the panel, including changes not refreshed yet. */
+static uint8_t framebuffer[IL0323_BUFFER_SIZE];
+/* One window of last_buffer or framebuffer, gathered into consecutive rows to send. */
+static uint8_t window_buffer[IL0323_BUFFER_SIZE];
+
+static struct il0323_window dirty;
+static bool dirty_valid = false;
+static bool full_refresh_pending = true;
+static uint32_t partial_refreshes = 0;
+
 static bool blanking_on = true;
 static bool init_clear_done = false;
 
+/* Serializes access to the controller and buffers between writes and the busy interrupt. */
+static K_MUTEX_DEFINE(il0323_lock);
+static K_SEM_DEFINE(il0323_busy_sem, 0, 1);
+static struct gpio_callback il0323_busy_cb;
+static struct k_work il0323_flush_work;
+
+/*
+ * The queue LVGL writes from. Flushes queued there run only after every area of the current frame
+ * has been written, so a frame is sent as one region.
+ */
+static struct k_work_q *il0323_work_q(void) {
+#if IS_ENABLED(CONFIG_ZMK_DISPLAY)
+    return zmk_display_work_q();
+#else
+    return &k_sys_work_q;
+#endif
+}
+
 static inline int il0323_write_cmd(const struct il0323_cfg *cfg, uint8_t cmd, uint8_t *data,
                                    size_t len) {
     struct spi_buf buf = {.buf = &cmd, .len = sizeof(cmd)};
@@ -71,14 +110,17 @@ static inline int il0323_write_cmd(const struct il0323_cfg *cfg, uint8_t cmd, ui
     return 0;
 }
 
-static inline void il0323_busy_wait(const struct il0323_cfg *cfg) {
+static inline bool il0323_is_busy(const struct il0323_cfg *cfg) {
     int pin = gpio_pin_get_dt(&cfg->busy);
 
-    while (pin > 0) {
-        __ASSERT(pin >= 0, "Failed to get pin level");
-        // LOG_DBG("wait %u", pin);
-        k_msleep(IL0323_BUSY_DELAY);
-        pin = gpio_pin_get_dt(&cfg->busy);
+    __ASSERT(pin >= 0, "Failed to get pin level");
+    return pin > 0;
+}
+
+static inline void il0323_busy_wait(const struct il0323_cfg *cfg) {
+    while (il0323_is_busy(cfg)) {
+        /* Woken by the busy interrupt. The timeout only covers an edge before the take. */
+        k_sem_take(&il0323_busy_sem, K_MSEC(IL0323_BUSY_TIMEOUT));
     }
 }
 
@@ -95,125 +137,208 @@ static int il0323_update_display(const struct device *dev) {
     return 0;
 }
 
-static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
-                        const struct display_buffer_descriptor *desc, const void *buf) {
-    const struct il0323_cfg *cfg = dev->config;
-    uint16_t x_end_idx = x + desc->width - 1;
-    uint16_t y_end_idx = y + desc->height - 1;
-    uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
-    size_t buf_len;
+static void il0323_mark_dirty(const struct il0323_window *window) {
+    if (!dirty_valid) {
+        dirty = *window;
+        dirty_valid = true;
+        return;
+    }
 
-    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
-            desc->pitch);
+    dirty.x_start = MIN(dirty.x_start, window->x_start);
+    dirty.x_end = MAX(dirty.x_end, window->x_end);
+    dirty.y_start = MIN(dirty.y_start, window->y_start);
+    dirty.y_end = MAX(dirty.y_end, window->y_end);
+}
 
-    buf_len = MIN(desc->buf_size, desc->height * desc->width / IL0323_PIXELS_PER_BYTE);
-    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
-    __ASSERT(buf != NULL, "Buffer is not available");
-    __ASSERT(buf_len != 0U, "Buffer of length zero");
-    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
-             IL0323_PIXELS_PER_BYTE);
+static size_t il0323_gather_window(const uint8_t *src, const struct il0323_window *window) {
+    const size_t first_page = window->x_start / IL0323_PIXELS_PER_BYTE;
+    const size_t row_len = window->x_end / IL0323_PIXELS_PER_BYTE - first_page + 1;
+    size_t len = 0;
 
-    LOG_DBG("buf_len %d", buf_len);
-    if ((y_end_idx > (EPD_PANEL_HEIGHT - 1)) || (x_end_idx > (EPD_PANEL_WIDTH - 1))) {
-        LOG_ERR("Position out of bounds");
-        return -EINVAL;
+    for (uint16_t y = window->y_start; y <= window->y_end; y++) {
+        memcpy(&window_buffer[len], &src[y * IL0323_NUMOF_PAGES + first_page], row_len);
+        len += row_len;
     }
 
-    /* Setup Partial Window and enable Partial Mode */
-    ptl[IL0323_PTL_HRST_IDX] = x;
-    ptl[IL0323_PTL_HRED_IDX] = x_end_idx;
-    ptl[IL0323_PTL_VRST_IDX] = y;
-    ptl[IL0323_PTL_VRED_IDX] = y_end_idx;
-    ptl[sizeof(ptl) - 1] = IL0323_PTL_PT_SCAN;
-    LOG_HEXDUMP_DBG(ptl, sizeof(ptl), "ptl");
+    return len;
+}
 
-    il0323_busy_wait(cfg);
-    if (il0323_write_cmd(cfg, IL0323_CMD_PIN, NULL, 0)) {
-        return -EIO;
+static void il0323_copy_window(uint8_t *dst, const uint8_t *src,
+                               const struct il0323_window *window) {
+    const size_t first_page = window->x_start / IL0323_PIXELS_PER_BYTE;
+    const size_t row_len = window->x_end / IL0323_PIXELS_PER_BYTE - first_page + 1;
+
+    for (uint16_t y = window->y_start; y <= window->y_end; y++) {
+        const size_t offset = y * IL0323_NUMOF_PAGES + first_page;
+        memcpy(&dst[offset], &src[offset], row_len);
     }
+}
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_PTL, ptl, sizeof(ptl))) {
-        return -EIO;
+/*
+ * Send the changed region of the panel and start refreshing it. Returns without waiting for the
+ * refresh, and does nothing while a refresh is still running: the busy interrupt queues this again
+ * once the panel is done, with everything written in the meantime merged into one region.
+ *
+ * Must be called with il0323_lock held.
+ */
+static int il0323_flush(const struct device *dev) {
+    const struct il0323_cfg *cfg = dev->config;
+    static const struct il0323_window panel = {
+        .x_start = 0,
+        .x_end = EPD_PANEL_WIDTH - 1,
+        .y_start = IL0323_PANEL_FIRST_GATE,
+        .y_end = IL0323_PANEL_LAST_GATE,
+    };
+    size_t len;
+
+    if (blanking_on || !dirty_valid || il0323_is_busy(cfg)) {
+        return 0;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM1, last_buffer, IL0323_BUFFER_SIZE)) {
+    /* Partial refreshes leave ghosting behind, so every so often redraw the whole panel. */
+    const bool full = full_refresh_pending ||
+                      partial_refreshes >= CONFIG_IL0323_FULL_REFRESH_INTERVAL;
+    const struct il0323_window window = full ? panel : dirty;
+
+    dirty_valid = false;
+
+    LOG_DBG("%s refresh of x %u-%u, y %u-%u", full ? "Full" : "Partial", window.x_start,
+            window.x_end, window.y_start, window.y_end);
+
+    if (!full) {
+        uint8_t ptl[IL0323_PTL_REG_LENGTH] = {0};
+
+        ptl[IL0323_PTL_HRST_IDX] = window.x_start;
+        ptl[IL0323_PTL_HRED_IDX] = window.x_end;
+        ptl[IL0323_PTL_VRST_IDX] = window.y_start;
+        ptl[IL0323_PTL_VRED_IDX] = window.y_end;
+        ptl[sizeof(ptl) - 1] = IL0323_PTL_PT_SCAN;
+        LOG_HEXDUMP_DBG(ptl, sizeof(ptl), "ptl");
+
+        if (il0323_write_cmd(cfg, IL0323_CMD_PIN, NULL, 0)) {
+            return -EIO;
+        }
+
+        if (il0323_write_cmd(cfg, IL0323_CMD_PTL, ptl, sizeof(ptl))) {
+            return -EIO;
+        }
+    }
+
+    len = il0323_gather_window(last_buffer, &window);
+    if (il0323_write_cmd(cfg, IL0323_CMD_DTM1, window_buffer, len)) {
         return -EIO;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, (uint8_t *)buf, buf_len)) {
+    len = il0323_gather_window(framebuffer, &window);
+    if (il0323_write_cmd(cfg, IL0323_CMD_DTM2, window_buffer, len)) {
         return -EIO;
     }
 
-    memcpy(last_buffer, (uint8_t *)buf, IL0323_BUFFER_SIZE);
+    il0323_copy_window(last_buffer, framebuffer, &window);
 
-    /* Update partial window and disable Partial Mode */
-    if (blanking_on == false) {
-        if (il0323_update_display(dev)) {
-            return -EIO;
-        }
+    if (il0323_update_display(dev)) {
+        return -EIO;
     }
 
-    if (il0323_write_cmd(cfg, IL0323_CMD_POUT, NULL, 0)) {
+    if (!full && il0323_write_cmd(cfg, IL0323_CMD_POUT, NULL, 0)) {
         return -EIO;
     }
 
+    if (full) {
+        full_refresh_pending = false;
+        partial_refreshes = 0;
+    } else {
+        partial_refreshes++;
+    }
+
     return 0;
 }
 
-static int il0323_read(const struct device *dev, const uint16_t x, const uint16_t y,
-                       const struct display_buffer_descriptor *desc, void *buf) {
-    LOG_ERR("not supported");
-    return -ENOTSUP;
+static void il0323_flush_work_cb(struct k_work *work) {
+    const struct device *dev = DEVICE_DT_INST_GET(0);
+
+    k_mutex_lock(&il0323_lock, K_FOREVER);
+    if (il0323_flush(dev)) {
+        LOG_ERR("Failed to refresh the panel");
+    }
+    k_mutex_unlock(&il0323_lock);
+}
+
+static void il0323_busy_handler(const struct device *port, struct gpio_callback *cb,
+                                gpio_port_pins_t pins) {
+    k_sem_give(&il0323_busy_sem);
+    k_work_submit_to_queue(il0323_work_q(), &il0323_flush_work);
 }
 
-static int il0323_clear_and_write_buffer(const struct device *dev, uint8_t pattern, bool update) {
-    struct display_buffer_descriptor desc = {
-        .buf_size = IL0323_NUMOF_PAGES,
-        .width = EPD_PANEL_WIDTH,
-        .height = 1,
-        .pitch = EPD_PANEL_WIDTH,
+static int il0323_write(const struct device *dev, const uint16_t x, const uint16_t y,
+                        const struct display_buffer_descriptor *desc, const void *buf) {
+    const struct il0323_window window = {
+        .x_start = x,
+        .x_end = x + desc->width - 1,
+        .y_start = y,
+        .y_end = y + desc->height - 1,
     };
-    uint8_t *line;
+    const size_t row_len = desc->width / IL0323_PIXELS_PER_BYTE;
+    const size_t pitch = desc->pitch / IL0323_PIXELS_PER_BYTE;
+    const uint8_t *src = buf;
 
-    line = k_malloc(IL0323_NUMOF_PAGES);
-    if (line == NULL) {
-        LOG_ERR("Failed to allocate memory for the clear");
-        return -ENOMEM;
-    }
+    LOG_DBG("x %u, y %u, height %u, width %u, pitch %u", x, y, desc->height, desc->width,
+            desc->pitch);
+
+    __ASSERT(desc->width <= desc->pitch, "Pitch is smaller then width");
+    __ASSERT(buf != NULL, "Buffer is not available");
+    __ASSERT(desc->buf_size >= (desc->height - 1) * pitch + row_len, "Buffer is too small");
+    __ASSERT(!(desc->width % IL0323_PIXELS_PER_BYTE), "Buffer width not multiple of %d",
+             IL0323_PIXELS_PER_BYTE);
+    __ASSERT(!(x % IL0323_PIXELS_PER_BYTE), "x not multiple of %d", IL0323_PIXELS_PER_BYTE);
 
-    memset(line, pattern, IL0323_NUMOF_PAGES);
-    for (int i = 0; i < EPD_PANEL_HEIGHT; i++) {
-        il0323_write(dev, 0, i, &desc, line);
+    if ((window.y_end > (EPD_PANEL_HEIGHT - 1)) || (window.x_end > (EPD_PANEL_WIDTH - 1))) {
+        LOG_ERR("Position out of bounds");
+        return -EINVAL;
     }
 
-    k_free(line);
+    k_mutex_lock(&il0323_lock, K_FOREVER);
 
-    if (update == true) {
-        if (il0323_update_display(dev)) {
-            return -EIO;
-        }
+    for (uint16_t row = 0; row < desc->height; row++) {
+        memcpy(&framebuffer[(y + row) * IL0323_NUMOF_PAGES + x / IL0323_PIXELS_PER_BYTE],
+               &src[row * pitch], row_len);
     }
 
+    il0323_mark_dirty(&window);
+
+    k_mutex_unlock(&il0323_lock);
+
+    /* LVGL may write more areas of the same frame next. Send them together once it is done. */
+    k_work_submit_to_queue(il0323_work_q(), &il0323_flush_work);
+
     return 0;
 }
 
+static int il0323_read(const struct device *dev, const uint16_t x, const uint16_t y,
+                       const struct display_buffer_descriptor *desc, void *buf) {
+    LOG_ERR("not supported");
+    return -ENOTSUP;
+}
+
 static int il0323_blanking_off(const struct device *dev) {
-    const struct il0323_cfg *cfg = dev->config;
+    k_mutex_lock(&il0323_lock, K_FOREVER);
 
     if (!init_clear_done) {
-        /* Update EPD panel in normal mode */
-        il0323_busy_wait(cfg);
-        if (il0323_clear_and_write_buffer(dev, 0xff, true)) {
-            return -EIO;
-        }
+        /* The panel's content is unknown until the first full refresh. */
+        full_refresh_pending = true;
+        dirty = (struct il0323_window){
+            .x_end = EPD_PANEL_WIDTH - 1,
+            .y_end = EPD_PANEL_HEIGHT - 1,
+        };
+        dirty_valid = true;
         init_clear_done = true;
     }
 
     blanking_on = false;
 
-    if (il0323_update_display(dev)) {
-        return -EIO;
-    }
+    k_mutex_unlock(&il0323_lock);
+
+    k_work_submit_to_queue(il0323_work_q(), &il0323_flush_work);
 
     return 0;
 }
@@ -368,6 +493,18 @@ static int il0323_init(const struct device *dev) {
 
     gpio_pin_configure_dt(&cfg->busy, GPIO_INPUT);
 
+    k_work_init(&il0323_flush_work, il0323_flush_work_cb);
+    gpio_init_callback(&il0323_busy_cb, il0323_busy_handler, BIT(cfg->busy.pin));
+    if (gpio_add_callback(cfg->busy.port, &il0323_busy_cb) ||
+        gpio_pin_interrupt_configure_dt(&cfg->busy, GPIO_INT_EDGE_TO_INACTIVE)) {
+        LOG_ERR("Could not configure the IL0323 busy interrupt");
+        return -EIO;
+    }
+
+    /* The first refresh clears the panel, as the driver has always done when unblanking. */
+    memset(framebuffer, 0xff, sizeof(framebuffer));
+    memset(last_buffer, 0xff, sizeof(last_buffer));
+
     return il0323_controller_init(dev);
 }
 
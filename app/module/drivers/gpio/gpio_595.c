@@ -41,6 +41,8 @@ struct reg_595_drv_data {
     struct k_sem lock;
 
     uint32_t gpio_cache;
+    /* Whether gpio_cache matches the registers, i.e. they have been written at least once */
+    bool gpio_cache_valid;
 };
 
 static int reg_595_write_registers(const struct device *dev, uint32_t value) {
@@ -48,6 +50,14 @@ static int reg_595_write_registers(const struct device *dev, uint32_t value) {
     struct reg_595_drv_data *const drv_data = (struct reg_595_drv_data *const)dev->data;
     int ret = 0;
 
+    /*
+     * Matrix scans switch outputs many times per millisecond, often to the value they already
+     * have. Skip the SPI transfer when nothing would change.
+     */
+    if (drv_data->gpio_cache_valid && value == drv_data->gpio_cache) {
+        return 0;
+    }
+
     uint8_t nwrite = config->ngpios / 8;
     uint32_t reg_data = sys_cpu_to_be32(value);
 
@@ -69,6 +79,7 @@ static int reg_595_write_registers(const struct device *dev, uint32_t value) {
     }
 
     drv_data->gpio_cache = value;
+    drv_data->gpio_cache_valid = true;
     return 0;
 }
 
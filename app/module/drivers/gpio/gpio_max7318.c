@@ -17,7 +17,9 @@
 #include <zephyr/init.h>
 #include <zephyr/sys/byteorder.h>
 #include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_utils.h>
 #include <zephyr/drivers/i2c.h>
+#include <zephyr/sys/atomic.h>
 
 #define LOG_LEVEL CONFIG_GPIO_LOG_LEVEL
 #include <zephyr/logging/log.h>
@@ -40,6 +42,9 @@ struct max7318_config {
 
     struct i2c_dt_spec i2c_bus;
     uint8_t ngpios;
+
+    // Optional connection to the chip's INT output. Without it, every port read goes to the bus.
+    struct gpio_dt_spec interrupt;
 };
 
 // Runtime driver data
@@ -53,7 +58,26 @@ struct max7318_drv_data {
         uint16_t ipol;
         uint16_t config;
         uint16_t output;
+        uint16_t input;
     } reg_cache;
+
+    // Set while reg_cache.input matches the chip. Cleared by the INT handler and after any write.
+    atomic_t input_valid;
+
+    const struct device *dev;
+    struct gpio_callback int_callback;
+    struct k_work int_work;
+    sys_slist_t callbacks;
+
+    // Input values last seen by the interrupt work, for edge detection.
+    uint16_t int_input;
+
+    // Pins with interrupts enabled, by trigger. Guarded by int_lock.
+    struct k_spinlock int_lock;
+    uint16_t int_rising;
+    uint16_t int_falling;
+    uint16_t int_high;
+    uint16_t int_low;
 };
 
 /**
@@ -114,6 +138,62 @@ static int write_registers(const struct device *dev, uint8_t reg, uint16_t value
     return i2c_burst_write_dt(&config->i2c_bus, reg, &data[0], sizeof(data));
 }
 
+/**
+ * @brief Read both input ports into the input cache
+ *
+ * Reading the input registers also releases the chip's INT output. Must be called with the lock
+ * held.
+ *
+ * @param dev   The max7318 device.
+ *
+ * @return 0 if successful, failed otherwise.
+ */
+static int read_inputs(const struct device *dev) {
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    // Mark the cache valid before reading, so an interrupt during the read invalidates it again.
+    atomic_set(&drv_data->input_valid, 1);
+
+    int ret = read_registers(dev, REG_INPUT_PORTA, &drv_data->reg_cache.input);
+    if (ret != 0) {
+        atomic_clear(&drv_data->input_valid);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Drop the input cache after writing outputs or directions
+ *
+ * Inputs wired to the chip's own outputs, such as matrix rows, can change as a result of the write
+ * before INT is asserted. Called after the write, even a failed one, with the lock held.
+ *
+ * @param dev   The max7318 device.
+ */
+static void invalidate_inputs(const struct device *dev) {
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    atomic_clear(&drv_data->input_valid);
+}
+
+/**
+ * @brief Check whether port reads can be served from the input cache
+ *
+ * INT stays asserted until the changed inputs are read, so checking the line as well as the cache
+ * flag also covers changes whose interrupt has not been handled yet.
+ *
+ * @param dev   The max7318 device.
+ *
+ * @return true if reg_cache.input matches the chip.
+ */
+static bool input_cache_is_valid(const struct device *dev) {
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    return config->interrupt.port != NULL && atomic_get(&drv_data->input_valid) &&
+           gpio_pin_get_dt(&config->interrupt) == 0;
+}
+
 /**
  * @brief Setup the pin direction (input or output)
  *
@@ -144,11 +224,13 @@ static int set_pin_direction(const struct device *dev, uint32_t pin, int flags)
     }
 
     int ret = write_registers(dev, REG_OUTPUT_PORTA, *output);
-    if (ret != 0) {
-        return ret;
+    if (ret == 0) {
+        ret = write_registers(dev, REG_CONFIG_PORTA, *dir);
     }
 
-    return write_registers(dev, REG_CONFIG_PORTA, *dir);
+    invalidate_inputs(dev);
+
+    return ret;
 }
 
 /**
@@ -215,13 +297,15 @@ static int max7318_port_get_raw(const struct device *dev, uint32_t *value) {
 
     k_sem_take(&drv_data->lock, K_FOREVER);
 
-    uint16_t buf = 0;
-    int ret = read_registers(dev, REG_INPUT_PORTA, &buf);
-    if (ret != 0) {
-        goto done;
+    int ret = 0;
+    if (!input_cache_is_valid(dev)) {
+        ret = read_inputs(dev);
+        if (ret != 0) {
+            goto done;
+        }
     }
 
-    *value = buf;
+    *value = drv_data->reg_cache.input;
 
 done:
     k_sem_give(&drv_data->lock);
@@ -246,6 +330,8 @@ static int max7318_port_set_masked_raw(const struct device *dev, uint32_t mask,
         drv_data->reg_cache.output = buf;
     }
 
+    invalidate_inputs(dev);
+
     k_sem_give(&drv_data->lock);
     return ret;
 }
@@ -276,13 +362,94 @@ static int max7318_port_toggle_bits(const struct device *dev, uint32_t mask) {
         drv_data->reg_cache.output = buf;
     }
 
+    invalidate_inputs(dev);
+
     k_sem_give(&drv_data->lock);
     return ret;
 }
 
 static int max7318_pin_interrupt_configure(const struct device *dev, gpio_pin_t pin,
                                            enum gpio_int_mode mode, enum gpio_int_trig trig) {
-    return -ENOTSUP;
+    const struct max7318_config *config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    if (config->interrupt.port == NULL) {
+        return -ENOTSUP;
+    }
+
+    const bool edge = mode == GPIO_INT_MODE_EDGE;
+    const bool level = mode == GPIO_INT_MODE_LEVEL;
+    const bool high = (trig & GPIO_INT_TRIG_HIGH) != 0;
+    const bool low = (trig & GPIO_INT_TRIG_LOW) != 0;
+
+    k_spinlock_key_t key = k_spin_lock(&drv_data->int_lock);
+
+    WRITE_BIT(drv_data->int_rising, pin, edge && high);
+    WRITE_BIT(drv_data->int_falling, pin, edge && low);
+    WRITE_BIT(drv_data->int_high, pin, level && high);
+    WRITE_BIT(drv_data->int_low, pin, level && low);
+
+    k_spin_unlock(&drv_data->int_lock, key);
+
+    // A level interrupt fires immediately if the pin is already at that level.
+    if (level) {
+        k_work_submit(&drv_data->int_work);
+    }
+
+    return 0;
+}
+
+static int max7318_manage_callback(const struct device *dev, struct gpio_callback *callback,
+                                   bool set) {
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    return gpio_manage_callback(&drv_data->callbacks, callback, set);
+}
+
+/**
+ * @brief Handle the chip's INT output
+ *
+ * INT means at least one input changed since the last read. The cache is dropped here, and the
+ * bus read that pin interrupts need is deferred to max7318_int_work_handler().
+ */
+static void max7318_int_handler(const struct device *port, struct gpio_callback *cb,
+                                gpio_port_pins_t pins) {
+    struct max7318_drv_data *const drv_data =
+        CONTAINER_OF(cb, struct max7318_drv_data, int_callback);
+
+    atomic_clear(&drv_data->input_valid);
+    k_work_submit(&drv_data->int_work);
+}
+
+static void max7318_int_work_handler(struct k_work *work) {
+    struct max7318_drv_data *const drv_data = CONTAINER_OF(work, struct max7318_drv_data, int_work);
+    const struct device *dev = drv_data->dev;
+
+    k_sem_take(&drv_data->lock, K_FOREVER);
+
+    int ret = input_cache_is_valid(dev) ? 0 : read_inputs(dev);
+    const uint16_t input = drv_data->reg_cache.input;
+
+    k_sem_give(&drv_data->lock);
+
+    if (ret != 0) {
+        LOG_ERR("error reading inputs after interrupt (%d)", ret);
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&drv_data->int_lock);
+
+    const uint16_t changed = drv_data->int_input ^ input;
+    const uint16_t pins = (changed & input & drv_data->int_rising) |
+                          (changed & ~input & drv_data->int_falling) |
+                          (input & drv_data->int_high) | (~input & drv_data->int_low);
+    drv_data->int_input = input;
+
+    k_spin_unlock(&drv_data->int_lock, key);
+
+    if (pins != 0) {
+        gpio_fire_callbacks(&drv_data->callbacks, dev, pins);
+    }
 }
 
 static const struct gpio_driver_api api_table = {
@@ -293,8 +460,51 @@ static const struct gpio_driver_api api_table = {
     .port_clear_bits_raw = max7318_port_clear_bits_raw,
     .port_toggle_bits = max7318_port_toggle_bits,
     .pin_interrupt_configure = max7318_pin_interrupt_configure,
+    .manage_callback = max7318_manage_callback,
 };
 
+/**
+ * @brief Set up the connection to the chip's INT output
+ *
+ * @param dev Device struct
+ * @return 0 if successful, failed otherwise.
+ */
+static int max7318_interrupt_init(const struct device *dev) {
+    const struct max7318_config *const config = dev->config;
+    struct max7318_drv_data *const drv_data = (struct max7318_drv_data *const)dev->data;
+
+    if (!device_is_ready(config->interrupt.port)) {
+        LOG_WRN("interrupt gpio not ready!");
+        return -EINVAL;
+    }
+
+    k_work_init(&drv_data->int_work, max7318_int_work_handler);
+
+    int ret = gpio_pin_configure_dt(&config->interrupt, GPIO_INPUT);
+    if (ret != 0) {
+        LOG_ERR("error configuring interrupt gpio (%d)", ret);
+        return ret;
+    }
+
+    gpio_init_callback(&drv_data->int_callback, max7318_int_handler, BIT(config->interrupt.pin));
+
+    ret = gpio_add_callback(config->interrupt.port, &drv_data->int_callback);
+    if (ret != 0) {
+        LOG_ERR("error adding interrupt callback (%d)", ret);
+        return ret;
+    }
+
+    // Read the inputs once to release INT and give edge detection a starting point.
+    ret = read_inputs(dev);
+    if (ret != 0) {
+        return ret;
+    }
+
+    drv_data->int_input = drv_data->reg_cache.input;
+
+    return gpio_pin_interrupt_configure_dt(&config->interrupt, GPIO_INT_EDGE_TO_ACTIVE);
+}
+
 /**
  * @brief Initialisation function of MAX7318
  *
@@ -310,9 +520,18 @@ static int max7318_init(const struct device *dev) {
         return -EINVAL;
     }
 
+    drv_data->dev = dev;
+    k_sem_init(&drv_data->lock, 1, 1);
+
+    if (config->interrupt.port != NULL) {
+        int ret = max7318_interrupt_init(dev);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
     LOG_INF("device initialised at 0x%x", config->i2c_bus.addr);
 
-    k_sem_init(&drv_data->lock, 1, 1);
     return 0;
 }
 
@@ -324,7 +543,8 @@ static int max7318_init(const struct device *dev) {
 #define MAX7318_INIT(inst)                                                                         \
     static struct max7318_config max7318_##inst##_config = {                                       \
         .common = {.port_pin_mask = GPIO_PORT_PIN_MASK_FROM_DT_INST(inst)},                        \
-        .i2c_bus = I2C_DT_SPEC_INST_GET(inst)};                                                    \
+        .i2c_bus = I2C_DT_SPEC_INST_GET(inst),                                                     \
+        .interrupt = GPIO_DT_SPEC_INST_GET_OR(inst, interrupt_gpios, {0})};                        \
                                                                                                    \
     static struct max7318_drv_data max7318_##inst##_drvdata = {                                    \
         /* Default for registers according to datasheet */                                         \
@@ -12,13 +12,34 @@ static int compare_ports(const void *a, const void *b) {
     const struct kscan_gpio *gpio_a = a;
     const struct kscan_gpio *gpio_b = b;
 
-    return gpio_a->spec.port - gpio_b->spec.port;
+    if (gpio_a->spec.port != gpio_b->spec.port) {
+        return gpio_a->spec.port < gpio_b->spec.port ? -1 : 1;
+    }
+
+    return gpio_a->spec.pin - gpio_b->spec.pin;
 }
 
 void kscan_gpio_list_sort_by_port(struct kscan_gpio_list *list) {
     qsort(list->gpios, list->len, sizeof(list->gpios[0]), compare_ports);
 }
 
+size_t kscan_gpio_list_group_by_port(const struct kscan_gpio_list *list,
+                                     struct kscan_gpio_port_group *groups) {
+    size_t len = 0;
+
+    for (size_t i = 0; i < list->len; i++) {
+        const struct gpio_dt_spec *spec = &list->gpios[i].spec;
+
+        if (len == 0 || groups[len - 1].port != spec->port) {
+            groups[len++] = (struct kscan_gpio_port_group){.port = spec->port, .first = i};
+        }
+
+        groups[len - 1].pins |= BIT(spec->pin);
+    }
+
+    return len;
+}
+
 int kscan_gpio_pin_get(const struct kscan_gpio *gpio, struct kscan_gpio_port_state *state) {
     if (gpio->spec.port != state->port) {
         state->port = gpio->spec.port;
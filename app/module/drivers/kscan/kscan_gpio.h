@@ -38,10 +38,44 @@ struct kscan_gpio_port_state {
 };
 
 /**
- * Sorts a GPIO list by port so it can be used with kscan_gpio_pin_get().
+ * The pins of a GPIO list that share a port, so they can be read or written with one call.
+ */
+struct kscan_gpio_port_group {
+    const struct device *port;
+    gpio_port_pins_t pins;
+    /** Index in the list of the first GPIO on this port. */
+    size_t first;
+};
+
+/**
+ * Sorts a GPIO list by port, then by pin, so it can be used with kscan_gpio_pin_get() and
+ * kscan_gpio_list_group_by_port().
  */
 void kscan_gpio_list_sort_by_port(struct kscan_gpio_list *list);
 
+/**
+ * Splits a list sorted by kscan_gpio_list_sort_by_port() into one group per port.
+ *
+ * @param list The sorted GPIO list.
+ * @param groups Array to fill, which must have room for list->len groups.
+ *
+ * @returns the number of groups.
+ */
+size_t kscan_gpio_list_group_by_port(const struct kscan_gpio_list *list,
+                                     struct kscan_gpio_port_group *groups);
+
+/**
+ * Get the GPIO of a port group connected to a pin in the group.
+ *
+ * The GPIOs of a group are sorted by pin, so the GPIO for a pin is the one after every lower pin
+ * in the group.
+ */
+static inline const struct kscan_gpio *
+kscan_gpio_port_group_get(const struct kscan_gpio_list *list,
+                          const struct kscan_gpio_port_group *group, const gpio_pin_t pin) {
+    return &list->gpios[group->first + POPCOUNT(group->pins & BIT_MASK(pin))];
+}
+
 /**
  * Get logical level of an input pin.
  *
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include "kscan_scan_rate.h"
+
 #include <zmk/debounce.h>
 
 #include <zephyr/device.h>
@@ -36,6 +38,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
     DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_release_ms))
 #endif
 
+#define INST_DEBOUNCE_ALGORITHM(n) DT_INST_ENUM_IDX(n, debounce_algorithm)
+
 #define KSCAN_GPIO_CFG_INIT(idx, inst_idx)                                                         \
     GPIO_DT_SPEC_GET_BY_IDX(DT_DRV_INST(inst_idx), gpios, idx)
 
@@ -64,6 +68,7 @@ struct kscan_charlieplex_data {
     kscan_callback_t callback;
     struct k_work_delayable work;
     int64_t scan_time; /* Timestamp of the current or scheduled scan. */
+    struct kscan_scan_rate scan_rate;
     struct gpio_callback irq_callback;
     /**
      * Current state of the matrix as a flattened 2D array of length
@@ -85,6 +90,7 @@ struct kscan_charlieplex_config {
     struct kscan_gpio_list cells;
     struct zmk_debounce_config debounce_config;
     int32_t debounce_scan_period_ms;
+    int32_t held_scan_period_ms;
     int32_t poll_period_ms;
     bool use_interrupt;
     const struct gpio_dt_spec interrupt;
@@ -209,11 +215,13 @@ static void kscan_charlieplex_irq_callback(const struct device *port, struct gpi
     k_work_reschedule(&data->work, K_NO_WAIT);
 }
 
-static void kscan_charlieplex_read_continue(const struct device *dev) {
+static void kscan_charlieplex_read_continue(const struct device *dev, const bool settling) {
     const struct kscan_charlieplex_config *config = dev->config;
     struct kscan_charlieplex_data *data = dev->data;
 
-    data->scan_time += config->debounce_scan_period_ms;
+    data->scan_time += kscan_scan_rate_next(dev, &data->scan_rate, settling,
+                                            config->debounce_scan_period_ms,
+                                            config->held_scan_period_ms);
 
     k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
 }
@@ -222,6 +230,8 @@ static void kscan_charlieplex_read_end(const struct device *dev) {
     struct kscan_charlieplex_data *data = dev->data;
     const struct kscan_charlieplex_config *config = dev->config;
 
+    kscan_scan_rate_reset(&data->scan_rate);
+
     if (config->use_interrupt) {
         // Return to waiting for an interrupt.
         kscan_charlieplex_interrupt_enable(dev);
@@ -237,6 +247,7 @@ static int kscan_charlieplex_read(const struct device *dev) {
     struct kscan_charlieplex_data *data = dev->data;
     const struct kscan_charlieplex_config *config = dev->config;
     bool continue_scan = false;
+    bool settling = false;
 
     // NOTE: RR vs MATRIX: set all pins as input, in case there was a failure on a
     // previous scan, and one of the pins is still set as output
@@ -277,6 +288,8 @@ static int kscan_charlieplex_read(const struct device *dev) {
                 data->callback(dev, row, col, pressed);
             }
             continue_scan = continue_scan || zmk_debounce_is_active(state);
+            settling = settling || zmk_debounce_get_changed(state) ||
+                       zmk_debounce_is_settling(state);
         }
 
         err = kscan_charlieplex_set_as_input(out_gpio);
@@ -291,7 +304,7 @@ static int kscan_charlieplex_read(const struct device *dev) {
     if (continue_scan) {
         // At least one key is pressed or the debouncer has not yet decided if
         // it is pressed. Poll quickly until everything is released.
-        kscan_charlieplex_read_continue(dev);
+        kscan_charlieplex_read_continue(dev, settling);
     } else {
         // All keys are released. Return to normal.
         kscan_charlieplex_read_end(dev);
@@ -405,10 +418,12 @@ static const struct kscan_driver_api kscan_charlieplex_api = {
         .cells = KSCAN_GPIO_LIST(kscan_charlieplex_cells_##n),                                     \
         .debounce_config =                                                                         \
             {                                                                                      \
+                .algorithm = INST_DEBOUNCE_ALGORITHM(n),                                           \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
             },                                                                                     \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .held_scan_period_ms = DT_INST_PROP(n, held_scan_period_ms),                               \
         COND_ANY_POLLING((.poll_period_ms = DT_INST_PROP(n, poll_period_ms), ))                    \
             COND_POLL_AND_INTR((.use_interrupt = INST_INTR_DEFINED(n), ))                          \
                 COND_THIS_INTERRUPT(n, (.interrupt = KSCAN_INTR_CFG_INIT(n), ))};                  \
@@ -34,6 +34,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
     DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_release_ms))
 #endif
 
+#define INST_DEBOUNCE_ALGORITHM(n) DT_INST_ENUM_IDX(n, debounce_algorithm)
+
 #define USE_POLLING IS_ENABLED(CONFIG_ZMK_KSCAN_DIRECT_POLLING)
 #define USE_INTERRUPTS (!USE_POLLING)
 
@@ -346,6 +348,7 @@ static const struct kscan_driver_api kscan_direct_api = {
     static struct kscan_direct_config kscan_direct_config_##n = {                                  \
         .debounce_config =                                                                         \
             {                                                                                      \
+                .algorithm = INST_DEBOUNCE_ALGORITHM(n),                                           \
                 .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
                 .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
             },                                                                                     \
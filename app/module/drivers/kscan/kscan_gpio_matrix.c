@@ -5,6 +5,7 @@
  */
 
 #include "kscan_gpio.h"
+#include "kscan_scan_rate.h"
 
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
@@ -13,7 +14,9 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/__assert.h>
+#include <zephyr/sys/math_extras.h>
 #include <zephyr/sys/util.h>
+#include <string.h>
 
 #include <zmk/debounce.h>
 
@@ -27,8 +30,9 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #define INST_ROWS_LEN(n) DT_INST_PROP_LEN(n, row_gpios)
 #define INST_COLS_LEN(n) DT_INST_PROP_LEN(n, col_gpios)
-#define INST_MATRIX_LEN(n) (INST_ROWS_LEN(n) * INST_COLS_LEN(n))
 #define INST_INPUTS_LEN(n) COND_DIODE_DIR(n, (INST_COLS_LEN(n)), (INST_ROWS_LEN(n)))
+#define INST_OUTPUTS_LEN(n) COND_DIODE_DIR(n, (INST_ROWS_LEN(n)), (INST_COLS_LEN(n)))
+#define INST_INPUT_SLICES(n) DIV_ROUND_UP(INST_INPUTS_LEN(n), ZMK_DEBOUNCE_SLICE_WIDTH)
 
 #if CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS >= 0
 #define INST_DEBOUNCE_PRESS_MS(n) CONFIG_ZMK_KSCAN_DEBOUNCE_PRESS_MS
@@ -44,6 +48,8 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
     DT_INST_PROP_OR(n, debounce_period, DT_INST_PROP(n, debounce_release_ms))
 #endif
 
+#define INST_DEBOUNCE_ALGORITHM(n) DT_INST_ENUM_IDX(n, debounce_algorithm)
+
 #define USE_POLLING IS_ENABLED(CONFIG_ZMK_KSCAN_MATRIX_POLLING)
 #define USE_INTERRUPTS (!USE_POLLING)
 
@@ -69,6 +75,11 @@ struct kscan_matrix_irq_callback {
 struct kscan_matrix_data {
     const struct device *dev;
     struct kscan_gpio_list inputs;
+    /**
+     * Sorted by port at init, which also sets the scan order. Matrix positions come from each
+     * output's index, so the order does not change them.
+     */
+    struct kscan_gpio_list outputs;
     kscan_callback_t callback;
     struct k_work_delayable work;
 #if USE_INTERRUPTS
@@ -77,54 +88,115 @@ struct kscan_matrix_data {
 #endif
     /** Timestamp of the current or scheduled scan. */
     int64_t scan_time;
+    struct kscan_scan_rate scan_rate;
     /**
-     * Current state of the matrix as a flattened 2D array of length
-     * (config->rows * config->cols)
+     * Current state of the matrix as a flattened 2D array of debounce slices, one row of
+     * config->input_slices slices per output. Bit N of slice S holds input S * 32 + N.
      */
-    struct zmk_debounce_state *matrix_state;
+    struct zmk_debounce_slice *matrix_state;
+    /** Switches that changed in the last scan, laid out like matrix_state. */
+    uint32_t *matrix_changed;
+    /** Inputs read active for the current output. Array of length config->input_slices. */
+    uint32_t *input_active;
+    /** Inputs grouped by port, so each port is read once per output. */
+    struct kscan_gpio_port_group *input_ports;
+    size_t input_ports_len;
+    /** Outputs grouped by port, so they can all be set with one write per port. */
+    struct kscan_gpio_port_group *output_ports;
+    size_t output_ports_len;
 };
 
 struct kscan_matrix_config {
-    struct kscan_gpio_list outputs;
-    struct zmk_debounce_config debounce_config;
+    struct zmk_debounce_slice_config debounce_config;
     size_t rows;
     size_t cols;
+    size_t input_slices;
     int32_t debounce_scan_period_ms;
+    int32_t held_scan_period_ms;
     int32_t poll_period_ms;
     enum kscan_diode_direction diode_direction;
 };
 
 /**
- * Get the index into a matrix state array from a row and column.
+ * Get the index into the matrix state arrays of the slice holding an input for an output.
  */
-static int state_index_rc(const struct kscan_matrix_config *config, const int row, const int col) {
-    __ASSERT(row < config->rows, "Invalid row %i", row);
-    __ASSERT(col < config->cols, "Invalid column %i", col);
+static int state_index_io(const struct kscan_matrix_config *config, const int input_idx,
+                          const int output_idx) {
+    return (output_idx * config->input_slices) + (input_idx / ZMK_DEBOUNCE_SLICE_WIDTH);
+}
+
+static int kscan_matrix_set_all_outputs(const struct device *dev, const int value) {
+    const struct kscan_matrix_data *data = dev->data;
+
+    for (int i = 0; i < data->output_ports_len; i++) {
+        const struct kscan_gpio_port_group *group = &data->output_ports[i];
+
+        int err = gpio_port_set_masked(group->port, group->pins, value ? group->pins : 0);
+        if (err) {
+            LOG_ERR("Failed to set outputs on %s to %i: %i", group->port->name, value, err);
+            return err;
+        }
+    }
 
-    return (col * config->rows) + row;
+    return 0;
 }
 
 /**
- * Get the index into a matrix state array from input/output pin indices.
+ * Switch the active output from @p prev to @p next, either of which may be NULL. When both are
+ * on the same port this is a single port write.
  */
-static int state_index_io(const struct kscan_matrix_config *config, const int input_idx,
-                          const int output_idx) {
-    return (config->diode_direction == KSCAN_ROW2COL)
-               ? state_index_rc(config, output_idx, input_idx)
-               : state_index_rc(config, input_idx, output_idx);
+static int kscan_matrix_select_output(const struct kscan_gpio *prev,
+                                      const struct kscan_gpio *next) {
+    if (prev && next && prev->spec.port == next->spec.port) {
+        return gpio_port_set_masked(next->spec.port, BIT(prev->spec.pin) | BIT(next->spec.pin),
+                                    BIT(next->spec.pin));
+    }
+
+    if (prev) {
+        int err = gpio_pin_set_dt(&prev->spec, 0);
+        if (err) {
+            LOG_ERR("Failed to set output %i inactive: %i", prev->index, err);
+            return err;
+        }
+    }
+
+    if (next) {
+        int err = gpio_pin_set_dt(&next->spec, 1);
+        if (err) {
+            LOG_ERR("Failed to set output %i active: %i", next->index, err);
+            return err;
+        }
+    }
+
+    return 0;
 }
 
-static int kscan_matrix_set_all_outputs(const struct device *dev, const int value) {
+/**
+ * Read every input port once and set the bits in data->input_active for the active inputs.
+ */
+static int kscan_matrix_read_inputs(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
 
-    for (int i = 0; i < config->outputs.len; i++) {
-        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+    memset(data->input_active, 0, config->input_slices * sizeof(data->input_active[0]));
 
-        int err = gpio_pin_set_dt(gpio, value);
+    for (int i = 0; i < data->input_ports_len; i++) {
+        const struct kscan_gpio_port_group *group = &data->input_ports[i];
+        gpio_port_value_t value;
+
+        int err = gpio_port_get(group->port, &value);
         if (err) {
-            LOG_ERR("Failed to set output %i to %i: %i", i, value, err);
+            LOG_ERR("Failed to read port %s: %i", group->port->name, err);
             return err;
         }
+
+        for (uint32_t pins = value & group->pins; pins; pins &= pins - 1) {
+            const struct kscan_gpio *in_gpio =
+                kscan_gpio_port_group_get(&data->inputs, group, u32_count_trailing_zeros(pins));
+
+            data->input_active[in_gpio->index / ZMK_DEBOUNCE_SLICE_WIDTH] |=
+                BIT(in_gpio->index % ZMK_DEBOUNCE_SLICE_WIDTH);
+        }
     }
 
     return 0;
@@ -190,21 +262,26 @@ static void kscan_matrix_irq_callback_handler(const struct device *port, struct
 }
 #endif
 
-static void kscan_matrix_read_continue(const struct device *dev) {
+static void kscan_matrix_read_continue(const struct device *dev, const bool settling) {
     const struct kscan_matrix_config *config = dev->config;
     struct kscan_matrix_data *data = dev->data;
 
-    data->scan_time += config->debounce_scan_period_ms;
+    data->scan_time += kscan_scan_rate_next(dev, &data->scan_rate, settling,
+                                            config->debounce_scan_period_ms,
+                                            config->held_scan_period_ms);
 
     k_work_reschedule(&data->work, K_TIMEOUT_ABS_MS(data->scan_time));
 }
 
 static void kscan_matrix_read_end(const struct device *dev) {
+    struct kscan_matrix_data *data = dev->data;
+
+    kscan_scan_rate_reset(&data->scan_rate);
+
 #if USE_INTERRUPTS
     // Return to waiting for an interrupt.
     kscan_matrix_interrupt_enable(dev);
 #else
-    struct kscan_matrix_data *data = dev->data;
     const struct kscan_matrix_config *config = dev->config;
 
     data->scan_time += config->poll_period_ms;
@@ -219,68 +296,82 @@ static int kscan_matrix_read(const struct device *dev) {
     const struct kscan_matrix_config *config = dev->config;
 
     // Scan the matrix.
-    for (int i = 0; i < config->outputs.len; i++) {
-        const struct kscan_gpio *out_gpio = &config->outputs.gpios[i];
+    const struct kscan_gpio *prev_gpio = NULL;
 
-        int err = gpio_pin_set_dt(&out_gpio->spec, 1);
+    for (int i = 0; i < data->outputs.len; i++) {
+        const struct kscan_gpio *out_gpio = &data->outputs.gpios[i];
+
+        int err = kscan_matrix_select_output(prev_gpio, out_gpio);
         if (err) {
-            LOG_ERR("Failed to set output %i active: %i", out_gpio->index, err);
             return err;
         }
 
 #if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS > 0
         k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BEFORE_INPUTS);
 #endif
-        struct kscan_gpio_port_state state = {0};
-
-        for (int j = 0; j < data->inputs.len; j++) {
-            const struct kscan_gpio *in_gpio = &data->inputs.gpios[j];
+        err = kscan_matrix_read_inputs(dev);
+        if (err) {
+            return err;
+        }
 
-            const int index = state_index_io(config, in_gpio->index, out_gpio->index);
-            const int active = kscan_gpio_pin_get(in_gpio, &state);
-            if (active < 0) {
-                LOG_ERR("Failed to read port %s: %i", in_gpio->spec.port->name, active);
-                return active;
-            }
+        for (int s = 0; s < config->input_slices; s++) {
+            const int index = state_index_io(config, s * ZMK_DEBOUNCE_SLICE_WIDTH, out_gpio->index);
 
-            zmk_debounce_update(&data->matrix_state[index], active, config->debounce_scan_period_ms,
-                                &config->debounce_config);
+            data->matrix_changed[index] = zmk_debounce_slice_update(
+                &data->matrix_state[index], data->input_active[s], &config->debounce_config);
         }
 
-        err = gpio_pin_set_dt(&out_gpio->spec, 0);
+#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
+        // Switch the output off and let the lines settle before driving the next one.
+        err = kscan_matrix_select_output(out_gpio, NULL);
         if (err) {
-            LOG_ERR("Failed to set output %i inactive: %i", out_gpio->index, err);
             return err;
         }
 
-#if CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS > 0
         k_busy_wait(CONFIG_ZMK_KSCAN_MATRIX_WAIT_BETWEEN_OUTPUTS);
+#else
+        // Leave the output active so it can be switched off in the same write that drives the
+        // next one.
+        prev_gpio = out_gpio;
 #endif
     }
 
+    int err = kscan_matrix_select_output(prev_gpio, NULL);
+    if (err) {
+        return err;
+    }
+
     // Process the new state.
     bool continue_scan = false;
+    bool settling = false;
 
-    for (int r = 0; r < config->rows; r++) {
-        for (int c = 0; c < config->cols; c++) {
-            const int index = state_index_rc(config, r, c);
-            struct zmk_debounce_state *state = &data->matrix_state[index];
+    for (int o = 0; o < data->outputs.len; o++) {
+        for (int s = 0; s < config->input_slices; s++) {
+            const int index = state_index_io(config, s * ZMK_DEBOUNCE_SLICE_WIDTH, o);
+            const struct zmk_debounce_slice *state = &data->matrix_state[index];
 
-            if (zmk_debounce_get_changed(state)) {
-                const bool pressed = zmk_debounce_is_pressed(state);
+            for (uint32_t changed = data->matrix_changed[index]; changed; changed &= changed - 1) {
+                const int lane = u32_count_trailing_zeros(changed);
+                const int input = s * ZMK_DEBOUNCE_SLICE_WIDTH + lane;
+                const int r = (config->diode_direction == KSCAN_ROW2COL) ? o : input;
+                const int c = (config->diode_direction == KSCAN_ROW2COL) ? input : o;
+                const bool pressed = zmk_debounce_slice_get_pressed(state) & BIT(lane);
 
                 LOG_DBG("Sending event at %i,%i state %s", r, c, pressed ? "on" : "off");
                 data->callback(dev, r, c, pressed);
             }
 
-            continue_scan = continue_scan || zmk_debounce_is_active(state);
+            continue_scan =
+                continue_scan || zmk_debounce_slice_get_active(state, &config->debounce_config);
+            settling = settling || data->matrix_changed[index] ||
+                       zmk_debounce_slice_get_settling(state, &config->debounce_config);
         }
     }
 
     if (continue_scan) {
         // At least one key is pressed or the debouncer has not yet decided if
         // it is pressed. Poll quickly until everything is released.
-        kscan_matrix_read_continue(dev);
+        kscan_matrix_read_continue(dev, settling);
     } else {
         // All keys are released. Return to normal.
         kscan_matrix_read_end(dev);
@@ -391,10 +482,10 @@ static int kscan_matrix_init_output_inst(const struct device *dev,
 }
 
 static int kscan_matrix_init_outputs(const struct device *dev) {
-    const struct kscan_matrix_config *config = dev->config;
+    const struct kscan_matrix_data *data = dev->data;
 
-    for (int i = 0; i < config->outputs.len; i++) {
-        const struct gpio_dt_spec *gpio = &config->outputs.gpios[i].spec;
+    for (int i = 0; i < data->outputs.len; i++) {
+        const struct gpio_dt_spec *gpio = &data->outputs.gpios[i].spec;
         int err = kscan_matrix_init_output_inst(dev, gpio);
         if (err) {
             return err;
@@ -409,8 +500,12 @@ static int kscan_matrix_init(const struct device *dev) {
 
     data->dev = dev;
 
-    // Sort inputs by port so we can read each port just once per scan.
+    // Sort inputs and outputs by port so we can read or write each port just once per step.
     kscan_gpio_list_sort_by_port(&data->inputs);
+    data->input_ports_len = kscan_gpio_list_group_by_port(&data->inputs, data->input_ports);
+
+    kscan_gpio_list_sort_by_port(&data->outputs);
+    data->output_ports_len = kscan_gpio_list_group_by_port(&data->outputs, data->output_ports);
 
     kscan_matrix_init_inputs(dev);
     kscan_matrix_init_outputs(dev);
@@ -439,7 +534,12 @@ static const struct kscan_driver_api kscan_matrix_api = {
     static struct kscan_gpio kscan_matrix_cols_##n[] = {                                           \
         LISTIFY(INST_COLS_LEN(n), KSCAN_GPIO_COL_CFG_INIT, (, ), n)};                              \
                                                                                                    \
-    static struct zmk_debounce_state kscan_matrix_state_##n[INST_MATRIX_LEN(n)];                   \
+    static struct zmk_debounce_slice                                                               \
+        kscan_matrix_state_##n[INST_OUTPUTS_LEN(n) * INST_INPUT_SLICES(n)];                        \
+    static uint32_t kscan_matrix_changed_##n[INST_OUTPUTS_LEN(n) * INST_INPUT_SLICES(n)];          \
+    static uint32_t kscan_matrix_input_active_##n[INST_INPUT_SLICES(n)];                           \
+    static struct kscan_gpio_port_group kscan_matrix_input_ports_##n[INST_INPUTS_LEN(n)];          \
+    static struct kscan_gpio_port_group kscan_matrix_output_ports_##n[INST_OUTPUTS_LEN(n)];        \
                                                                                                    \
     COND_INTERRUPTS(                                                                               \
         (static struct kscan_matrix_irq_callback kscan_matrix_irqs_##n[INST_INPUTS_LEN(n)];))      \
@@ -447,20 +547,24 @@ static const struct kscan_driver_api kscan_matrix_api = {
     static struct kscan_matrix_data kscan_matrix_data_##n = {                                      \
         .inputs =                                                                                  \
             KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_cols_##n), (kscan_matrix_rows_##n))),  \
+        .outputs =                                                                                 \
+            KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_rows_##n), (kscan_matrix_cols_##n))),  \
         .matrix_state = kscan_matrix_state_##n,                                                    \
+        .matrix_changed = kscan_matrix_changed_##n,                                                \
+        .input_active = kscan_matrix_input_active_##n,                                             \
+        .input_ports = kscan_matrix_input_ports_##n,                                               \
+        .output_ports = kscan_matrix_output_ports_##n,                                             \
         COND_INTERRUPTS((.irqs = kscan_matrix_irqs_##n, ))};                                       \
                                                                                                    \
     static struct kscan_matrix_config kscan_matrix_config_##n = {                                  \
         .rows = ARRAY_SIZE(kscan_matrix_rows_##n),                                                 \
         .cols = ARRAY_SIZE(kscan_matrix_cols_##n),                                                 \
-        .outputs =                                                                                 \
-            KSCAN_GPIO_LIST(COND_DIODE_DIR(n, (kscan_matrix_rows_##n), (kscan_matrix_cols_##n))),  \
-        .debounce_config =                                                                         \
-            {                                                                                      \
-                .debounce_press_ms = INST_DEBOUNCE_PRESS_MS(n),                                    \
-                .debounce_release_ms = INST_DEBOUNCE_RELEASE_MS(n),                                \
-            },                                                                                     \
+        .input_slices = INST_INPUT_SLICES(n),                                                      \
+        .debounce_config = ZMK_DEBOUNCE_SLICE_CONFIG(                                              \
+            INST_DEBOUNCE_ALGORITHM(n), INST_DEBOUNCE_PRESS_MS(n), INST_DEBOUNCE_RELEASE_MS(n),    \
+            DT_INST_PROP(n, debounce_scan_period_ms)),                                             \
         .debounce_scan_period_ms = DT_INST_PROP(n, debounce_scan_period_ms),                       \
+        .held_scan_period_ms = DT_INST_PROP(n, held_scan_period_ms),                               \
         .poll_period_ms = DT_INST_PROP(n, poll_period_ms),                                         \
         .diode_direction = INST_DIODE_DIR(n),                                                      \
     };                                                                                             \
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_kscan_replay
+
+/**
+ * @file Keyboard scan driver for native_posix which replays a recorded key log from a host file.
+ *
+ * Each non-empty line of the log that does not start with '#' is one event:
+ *
+ *     <delay-us> <row> <column> <pressed>
+ *
+ * where delay-us is the time since the previous event in microseconds and pressed is 1 or 0.
+ * Lines are read one at a time, so logs can be arbitrarily long. A line that can't be parsed, or a
+ * position outside the configured rows and columns, stops the replay.
+ */
+
+#include <stdio.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/kscan.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/sys/printk.h>
+
+#include <native_rtc.h>
+#include <posix_board_if.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/** Latencies are recorded with 1 us resolution up to this value. Longer ones share the last. */
+#define KSCAN_REPLAY_LATENCY_BUCKETS 4096
+
+struct kscan_replay_event {
+    uint32_t delay_us;
+    uint32_t row;
+    uint32_t column;
+    bool pressed;
+};
+
+struct kscan_replay_config {
+    const char *path;
+    uint32_t time_compression;
+    uint32_t rows;
+    uint32_t columns;
+    bool exit_after;
+};
+
+struct kscan_replay_data {
+    const struct device *dev;
+    kscan_callback_t callback;
+    struct k_work_delayable work;
+
+    FILE *file;
+    int line;
+    struct kscan_replay_event next;
+    bool has_next;
+    bool failed;
+    /* Uptime in ticks at which the next event is due. */
+    int64_t due_ticks;
+
+    /* Host time at which the last event was reported, or 0 once its latency is recorded. */
+    int64_t reported_us;
+    int64_t start_us;
+    uint32_t events;
+    uint64_t latency_total_us;
+    uint32_t latency_max_us;
+    uint32_t latency_histogram[KSCAN_REPLAY_LATENCY_BUCKETS];
+};
+
+static int64_t kscan_replay_now_us(void) { return native_rtc_gettime_us(RTC_CLOCK_REALTIME); }
+
+/**
+ * Read the next event from the log into data->next.
+ *
+ * @returns 0 on success, -ENODATA at the end of the log, or another negative errno on failure.
+ */
+static int kscan_replay_read_next(const struct device *dev) {
+    const struct kscan_replay_config *config = dev->config;
+    struct kscan_replay_data *data = dev->data;
+    char buf[64];
+
+    data->has_next = false;
+
+    while (fgets(buf, sizeof(buf), data->file) != NULL) {
+        unsigned int delay_us, row, column, pressed;
+
+        data->line++;
+
+        if (buf[0] == '#' || buf[0] == '\n' || buf[0] == '\r') {
+            continue;
+        }
+
+        if (sscanf(buf, "%u %u %u %u", &delay_us, &row, &column, &pressed) != 4) {
+            LOG_ERR("%s:%d: expected <delay-us> <row> <column> <pressed>", config->path,
+                    data->line);
+            return -EINVAL;
+        }
+
+        if (row >= config->rows || column >= config->columns) {
+            LOG_ERR("%s:%d: position %u,%u is outside the %ux%u matrix", config->path, data->line,
+                    row, column, config->rows, config->columns);
+            return -EINVAL;
+        }
+
+        data->next = (struct kscan_replay_event){
+            .delay_us = delay_us,
+            .row = row,
+            .column = column,
+            .pressed = pressed != 0,
+        };
+        data->has_next = true;
+
+        if (config->time_compression > 0) {
+            data->due_ticks += k_us_to_ticks_ceil64(delay_us / config->time_compression);
+        }
+
+        return 0;
+    }
+
+    if (ferror(data->file)) {
+        LOG_ERR("%s:%d: read failed", config->path, data->line + 1);
+        return -EIO;
+    }
+
+    return -ENODATA;
+}
+
+/** Read the next event, and stop the replay after the current one if that fails. */
+static void kscan_replay_advance(const struct device *dev) {
+    struct kscan_replay_data *data = dev->data;
+
+    int err = kscan_replay_read_next(dev);
+    if (err < 0 && err != -ENODATA) {
+        LOG_ERR("Stopping the replay (%d)", err);
+        data->failed = true;
+    }
+}
+
+static void kscan_replay_record_latency(struct kscan_replay_data *data, uint32_t latency_us) {
+    data->latency_total_us += latency_us;
+    data->latency_max_us = MAX(data->latency_max_us, latency_us);
+    data->latency_histogram[MIN(latency_us, KSCAN_REPLAY_LATENCY_BUCKETS - 1)]++;
+}
+
+static uint32_t kscan_replay_latency_percentile(const struct kscan_replay_data *data,
+                                                const int percent) {
+    const uint64_t target = DIV_ROUND_UP((uint64_t)data->events * percent, 100);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < KSCAN_REPLAY_LATENCY_BUCKETS; i++) {
+        seen += data->latency_histogram[i];
+        if (seen >= target) {
+            return i;
+        }
+    }
+
+    return KSCAN_REPLAY_LATENCY_BUCKETS - 1;
+}
+
+static void kscan_replay_finish(const struct device *dev) {
+    const struct kscan_replay_config *config = dev->config;
+    struct kscan_replay_data *data = dev->data;
+
+    fclose(data->file);
+    data->file = NULL;
+
+    if (data->events > 0) {
+        const long long elapsed_us = MAX(kscan_replay_now_us() - data->start_us, 1);
+        const unsigned long long rate = data->events * (uint64_t)USEC_PER_SEC / elapsed_us;
+        const unsigned long long mean_us = data->latency_total_us / data->events;
+
+        printk("%s: %u events in %lld us, %llu events/s\n", dev->name, data->events, elapsed_us,
+               rate);
+        printk("%s: latency us: mean %llu p50 %u p99 %u max %u\n", dev->name, mean_us,
+               kscan_replay_latency_percentile(data, 50), kscan_replay_latency_percentile(data, 99),
+               data->latency_max_us);
+    }
+
+    LOG_INF("Replay %s after %u events", data->failed ? "failed" : "finished", data->events);
+
+    if (config->exit_after) {
+        // Flush deferred log messages, including the report, before the process ends.
+        LOG_PANIC();
+        posix_exit(data->failed ? 1 : 0);
+    }
+}
+
+static void kscan_replay_work_handler(struct k_work *work) {
+    struct k_work_delayable *d_work = k_work_delayable_from_work(work);
+    struct kscan_replay_data *data = CONTAINER_OF(d_work, struct kscan_replay_data, work);
+    const struct device *dev = data->dev;
+
+    // The previous event was reported right before this work was queued, so by now the work the
+    // callback submitted has run it through the keymap, behaviors and HID.
+    if (data->reported_us != 0) {
+        kscan_replay_record_latency(data, kscan_replay_now_us() - data->reported_us);
+        data->reported_us = 0;
+    }
+
+    if (!data->has_next) {
+        kscan_replay_finish(dev);
+        return;
+    }
+
+    if (k_uptime_ticks() < data->due_ticks) {
+        k_work_schedule(&data->work, K_TIMEOUT_ABS_TICKS(data->due_ticks));
+        return;
+    }
+
+    const struct kscan_replay_event ev = data->next;
+
+    // Read ahead before reporting, so file access is not counted in the latency. A bad line ends
+    // the replay after this event.
+    kscan_replay_advance(dev);
+
+    LOG_DBG("row %d column %d state %d", ev.row, ev.column, ev.pressed);
+
+    data->reported_us = kscan_replay_now_us();
+    if (data->events++ == 0) {
+        data->start_us = data->reported_us;
+    }
+
+    data->callback(dev, ev.row, ev.column, ev.pressed);
+
+    k_work_schedule(&data->work, K_NO_WAIT);
+}
+
+static int kscan_replay_configure(const struct device *dev, kscan_callback_t callback) {
+    struct kscan_replay_data *data = dev->data;
+
+    if (!callback) {
+        return -EINVAL;
+    }
+
+    data->callback = callback;
+
+    return 0;
+}
+
+static int kscan_replay_enable_callback(const struct device *dev) {
+    const struct kscan_replay_config *config = dev->config;
+    struct kscan_replay_data *data = dev->data;
+
+    if (data->file == NULL) {
+        data->file = fopen(config->path, "r");
+        if (data->file == NULL) {
+            LOG_ERR("Failed to open %s", config->path);
+            return -ENOENT;
+        }
+
+        data->due_ticks = k_uptime_ticks();
+
+        kscan_replay_advance(dev);
+    }
+
+    k_work_schedule(&data->work, K_NO_WAIT);
+
+    return 0;
+}
+
+static int kscan_replay_disable_callback(const struct device *dev) {
+    struct kscan_replay_data *data = dev->data;
+
+    k_work_cancel_delayable(&data->work);
+
+    return 0;
+}
+
+static int kscan_replay_init(const struct device *dev) {
+    struct kscan_replay_data *data = dev->data;
+
+    data->dev = dev;
+    k_work_init_delayable(&data->work, kscan_replay_work_handler);
+
+    return 0;
+}
+
+static const struct kscan_driver_api kscan_replay_api = {
+    .config = kscan_replay_configure,
+    .enable_callback = kscan_replay_enable_callback,
+    .disable_callback = kscan_replay_disable_callback,
+};
+
+#define KSCAN_REPLAY_INIT(n)                                                                       \
+    static struct kscan_replay_data kscan_replay_data_##n;                                         \
+                                                                                                   \
+    static const struct kscan_replay_config kscan_replay_config_##n = {                            \
+        .path = DT_INST_PROP(n, path),                                                             \
+        .time_compression = DT_INST_PROP(n, time_compression),                                     \
+        .rows = DT_INST_PROP(n, rows),                                                             \
+        .columns = DT_INST_PROP(n, columns),                                                       \
+        .exit_after = DT_INST_PROP(n, exit_after),                                                 \
+    };                                                                                             \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, &kscan_replay_init, NULL, &kscan_replay_data_##n,                     \
+                          &kscan_replay_config_##n, POST_KERNEL, CONFIG_KSCAN_INIT_PRIORITY,       \
+                          &kscan_replay_api);
+
+DT_INST_FOREACH_STATUS_OKAY(KSCAN_REPLAY_INIT)
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "kscan_scan_rate.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+int32_t kscan_scan_rate_next(const struct device *dev, struct kscan_scan_rate *rate,
+                             const bool settling, const int32_t scan_period_ms,
+                             const int32_t held_period_ms) {
+    const int64_t now = k_uptime_get();
+
+    if (rate->scans++ == 0) {
+        rate->stats_start = now;
+    } else if (now - rate->stats_start >= MSEC_PER_SEC) {
+        LOG_DBG("%s: %lld scans/s, period %d ms", dev->name,
+                (int64_t)rate->scans * MSEC_PER_SEC / (now - rate->stats_start), rate->period_ms);
+        rate->scans = 0;
+    }
+
+    if (settling || rate->period_ms < scan_period_ms) {
+        rate->period_ms = scan_period_ms;
+        rate->stable_scans = 0;
+    } else if (rate->period_ms < held_period_ms &&
+               ++rate->stable_scans >= KSCAN_SCAN_RATE_BACKOFF_SCANS) {
+        rate->period_ms = MIN(rate->period_ms * 2, held_period_ms);
+        rate->stable_scans = 0;
+    }
+
+    return rate->period_ms;
+}
+
+void kscan_scan_rate_reset(struct kscan_scan_rate *rate) { *rate = (struct kscan_scan_rate){0}; }
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/**
+ * Scan rate while any key is active. Scans run every debounce-scan-period-ms while any switch is
+ * changing, then back off by doubling the period, up to held-scan-period-ms, for as long as every
+ * pressed switch is stable.
+ */
+struct kscan_scan_rate {
+    int32_t period_ms;
+    uint16_t stable_scans;
+    /** Scans since stats_start, for the scan rate log. */
+    uint32_t scans;
+    int64_t stats_start;
+};
+
+/** Stable scans at each period before backing off to the next one. */
+#define KSCAN_SCAN_RATE_BACKOFF_SCANS 8
+
+/**
+ * Record a scan and get the delay until the next one.
+ *
+ * @param dev The kscan device, for logging.
+ * @param rate The scan rate state.
+ * @param settling Whether any switch changed or is still being debounced.
+ * @param scan_period_ms The debounce scan period.
+ * @param held_period_ms The longest period to back off to, or 0 to never back off.
+ *
+ * @returns the delay in milliseconds until the next scan.
+ */
+int32_t kscan_scan_rate_next(const struct device *dev, struct kscan_scan_rate *rate,
+                             const bool settling, const int32_t scan_period_ms,
+                             const int32_t held_period_ms);
+
+/**
+ * Reset the scan rate once every key is released and the driver stops scanning continuously.
+ */
+void kscan_scan_rate_reset(struct kscan_scan_rate *rate);
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_led_strip_mock
+
+/**
+ * @file Stand-in LED strip for native_posix.
+ *
+ * Updates block the caller for as long as a real strip takes to clock the frame out, the way the
+ * SPI and I2S strip drivers wait for their transfer, so renderers see realistic timing. Each
+ * frame is logged with the time since the previous one, for tests of frame pacing.
+ */
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(led_strip_mock, CONFIG_LED_STRIP_LOG_LEVEL);
+
+struct led_strip_mock_config {
+    size_t chain_length;
+    uint32_t transfer_us;
+};
+
+struct led_strip_mock_data {
+    struct led_rgb *pixels;
+    uint32_t frames;
+    /* Uptime in ticks at which the last frame was latched. */
+    int64_t last_ticks;
+};
+
+static int led_strip_mock_update_rgb(const struct device *dev, struct led_rgb *pixels,
+                                     size_t num_pixels) {
+    const struct led_strip_mock_config *config = dev->config;
+    struct led_strip_mock_data *data = dev->data;
+
+    if (num_pixels > config->chain_length) {
+        return -EINVAL;
+    }
+
+    k_sleep(K_USEC(config->transfer_us));
+
+    memcpy(data->pixels, pixels, num_pixels * sizeof(struct led_rgb));
+
+    const int64_t now = k_uptime_ticks();
+    if (data->frames++ > 0) {
+        LOG_DBG("%s: frame %u, %u us after the last", dev->name, data->frames,
+                (uint32_t)k_ticks_to_us_floor64(now - data->last_ticks));
+    } else {
+        LOG_DBG("%s: frame %u", dev->name, data->frames);
+    }
+    data->last_ticks = now;
+
+    return 0;
+}
+
+static int led_strip_mock_update_channels(const struct device *dev, uint8_t *channels,
+                                          size_t num_channels) {
+    return -ENOTSUP;
+}
+
+static const struct led_strip_driver_api led_strip_mock_api = {
+    .update_rgb = led_strip_mock_update_rgb,
+    .update_channels = led_strip_mock_update_channels,
+};
+
+#define LED_STRIP_MOCK_INIT(n)                                                                     \
+    static struct led_rgb led_strip_mock_pixels_##n[DT_INST_PROP(n, chain_length)];                \
+                                                                                                   \
+    static struct led_strip_mock_data led_strip_mock_data_##n = {                                  \
+        .pixels = led_strip_mock_pixels_##n,                                                       \
+    };                                                                                             \
+                                                                                                   \
+    static const struct led_strip_mock_config led_strip_mock_config_##n = {                        \
+        .chain_length = DT_INST_PROP(n, chain_length),                                             \
+        .transfer_us = DT_INST_PROP(n, chain_length) * DT_INST_PROP(n, pixel_time_ns) / 1000 +     \
+                       DT_INST_PROP(n, reset_time_us),                                             \
+    };                                                                                             \
+                                                                                                   \
+    DEVICE_DT_INST_DEFINE(n, NULL, NULL, &led_strip_mock_data_##n, &led_strip_mock_config_##n,     \
+                          POST_KERNEL, CONFIG_LED_STRIP_INIT_PRIORITY, &led_strip_mock_api);
+
+DT_INST_FOREACH_STATUS_OKAY(LED_STRIP_MOCK_INIT)
@@ -11,12 +11,16 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/adc.h>
 #include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
 #include "battery_common.h"
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Time for any capacitance on the divider to charge up once it is powered.
+#define BVD_SETTLE_MS 10
+
 struct io_channel_config {
     uint8_t channel;
 };
@@ -33,6 +37,10 @@ struct bvd_data {
     struct adc_channel_cfg acc;
     struct adc_sequence as;
     struct battery_value value;
+#if DT_INST_NODE_HAS_PROP(0, power_gpios)
+    /* Uptime at which the divider was powered, or 0 while it is off. */
+    int64_t powered_at;
+#endif
 };
 
 static int bvd_sample_fetch(const struct device *dev, enum sensor_channel chan) {
@@ -50,16 +58,23 @@ static int bvd_sample_fetch(const struct device *dev, enum sensor_channel chan)
     int rc = 0;
 
 #if DT_INST_NODE_HAS_PROP(0, power_gpios)
-    // Enable power before sampling
-    rc = gpio_pin_set_dt(&drv_cfg->power, 1);
-
-    if (rc != 0) {
-        LOG_DBG("Failed to enable ADC power GPIO: %d", rc);
-        return rc;
+    // Enable power before sampling. Rather than blocking the caller while the divider settles,
+    // ask it to fetch again once it has.
+    if (drv_data->powered_at == 0) {
+        rc = gpio_pin_set_dt(&drv_cfg->power, 1);
+
+        if (rc != 0) {
+            LOG_DBG("Failed to enable ADC power GPIO: %d", rc);
+            return rc;
+        }
+
+        drv_data->powered_at = MAX(k_uptime_get(), 1);
+        return -EAGAIN;
     }
 
-    // wait for any capacitance to charge up
-    k_sleep(K_MSEC(10));
+    if (k_uptime_get() - drv_data->powered_at < BVD_SETTLE_MS) {
+        return -EAGAIN;
+    }
 #endif // DT_INST_NODE_HAS_PROP(0, power_gpios)
 
     // Read ADC
@@ -86,6 +101,7 @@ static int bvd_sample_fetch(const struct device *dev, enum sensor_channel chan)
 #if DT_INST_NODE_HAS_PROP(0, power_gpios)
     // Disable power GPIO if present
     int rc2 = gpio_pin_set_dt(&drv_cfg->power, 0);
+    drv_data->powered_at = 0;
 
     if (rc2 != 0) {
         LOG_DBG("Failed to disable ADC power GPIO: %d", rc2);
@@ -19,7 +19,30 @@ struct zmk_debounce_state {
     uint16_t counter : DEBOUNCE_COUNTER_BITS;
 };
 
+/**
+ * Debounce algorithms. The values match the order of the debounce-algorithm devicetree enum.
+ */
+enum zmk_debounce_algorithm {
+    /**
+     * Integrate the input: a switch latches once it has disagreed with its latched state for the
+     * press or release time, counting back down whenever it agrees. Resistant to noise, but every
+     * change is reported late by the debounce time.
+     */
+    ZMK_DEBOUNCE_INTEGRATOR,
+    /**
+     * Report a press as soon as it is seen. Report a release once the switch has stayed released
+     * for the release time, restarting the wait on any bounce back to pressed.
+     */
+    ZMK_DEBOUNCE_EAGER_PRESS,
+    /**
+     * Report every change as soon as it is seen, then ignore the switch for the press or release
+     * time of its new state. No added latency, but a single noise spike is reported as a tap.
+     */
+    ZMK_DEBOUNCE_EAGER,
+};
+
 struct zmk_debounce_config {
+    enum zmk_debounce_algorithm algorithm;
     /** Duration a switch must be pressed to latch as pressed. */
     uint32_t debounce_press_ms;
     /** Duration a switch must be released to latch as released. */
@@ -27,7 +50,7 @@ struct zmk_debounce_config {
 };
 
 /**
- * Debounces one switch.
+ * Debounces one switch using config->algorithm.
  *
  * @param state The state for the switch to debounce.
  * @param active Is the switch currently pressed?
@@ -44,6 +67,13 @@ void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, co
  */
 bool zmk_debounce_is_active(const struct zmk_debounce_state *state);
 
+/**
+ * @returns whether the debouncer is still deciding on the state of the switch because its input
+ * changed recently. While this and zmk_debounce_get_changed() are false, the switch is stable and
+ * may be scanned less often.
+ */
+bool zmk_debounce_is_settling(const struct zmk_debounce_state *state);
+
 /**
  * @returns whether the switch is latched as pressed.
  */
@@ -54,3 +84,81 @@ bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state);
  * debounce_update.
  */
 bool zmk_debounce_get_changed(const struct zmk_debounce_state *state);
+
+/**
+ * Bit-sliced debouncing.
+ *
+ * A slice debounces up to 32 switches at once with the same algorithms as zmk_debounce_update().
+ * Bit N of every word belongs to switch N, and the counter is stored as a "vertical" binary
+ * number across bit-planes, so each update is a handful of word operations no matter how many of
+ * the 32 switches are bouncing. Counters count scans rather than milliseconds, which is exact
+ * as long as every update of a slice is one scan period apart.
+ */
+#define ZMK_DEBOUNCE_SLICE_WIDTH 32
+#define ZMK_DEBOUNCE_SLICE_PLANES_MAX DEBOUNCE_COUNTER_BITS
+
+struct zmk_debounce_slice {
+    /** Switches latched as pressed. */
+    uint32_t pressed;
+    /** Counter bit-planes, least significant first. */
+    uint32_t counter[ZMK_DEBOUNCE_SLICE_PLANES_MAX];
+};
+
+struct zmk_debounce_slice_config {
+    enum zmk_debounce_algorithm algorithm;
+    /** Scans a switch must stay pressed, beyond the first, to latch as pressed. */
+    uint16_t press_scans;
+    /** Scans a switch must stay released, beyond the first, to latch as released. */
+    uint16_t release_scans;
+    /** Number of counter bit-planes needed to hold the larger of the two. */
+    uint8_t planes;
+};
+
+#define ZMK_DEBOUNCE_SLICE_SCANS(ms, scan_period_ms) DIV_ROUND_UP(ms, scan_period_ms)
+#define ZMK_DEBOUNCE_SLICE_PLANES(scans) (32 - __builtin_clz((scans) | 1))
+
+/**
+ * Initializer for a struct zmk_debounce_slice_config equivalent to the given
+ * struct zmk_debounce_config fields when updated every @p scan_period_ms.
+ */
+#define ZMK_DEBOUNCE_SLICE_CONFIG(algo, press_ms, release_ms, scan_period_ms)                      \
+    {                                                                                              \
+        .algorithm = algo,                                                                         \
+        .press_scans = ZMK_DEBOUNCE_SLICE_SCANS(press_ms, scan_period_ms),                         \
+        .release_scans = ZMK_DEBOUNCE_SLICE_SCANS(release_ms, scan_period_ms),                     \
+        .planes = ZMK_DEBOUNCE_SLICE_PLANES(                                                       \
+            MAX(ZMK_DEBOUNCE_SLICE_SCANS(press_ms, scan_period_ms),                                \
+                ZMK_DEBOUNCE_SLICE_SCANS(release_ms, scan_period_ms))),                            \
+    }
+
+/**
+ * Debounces up to 32 switches by one scan period.
+ *
+ * @param slice The state for the switches to debounce.
+ * @param active Bit mask of the switches that are currently pressed.
+ * @param config Debounce settings.
+ * @returns a bit mask of the switches whose latched state changed.
+ */
+uint32_t zmk_debounce_slice_update(struct zmk_debounce_slice *slice, const uint32_t active,
+                                   const struct zmk_debounce_slice_config *config);
+
+/**
+ * @returns a bit mask of the switches that are either latched as pressed or still being
+ * debounced. If this is non-zero, the kscan driver should continue to poll quickly.
+ */
+uint32_t zmk_debounce_slice_get_active(const struct zmk_debounce_slice *slice,
+                                       const struct zmk_debounce_slice_config *config);
+
+/**
+ * @returns a bit mask of the switches the debouncer is still deciding on. See
+ * zmk_debounce_is_settling().
+ */
+uint32_t zmk_debounce_slice_get_settling(const struct zmk_debounce_slice *slice,
+                                         const struct zmk_debounce_slice_config *config);
+
+/**
+ * @returns a bit mask of the switches latched as pressed.
+ */
+static inline uint32_t zmk_debounce_slice_get_pressed(const struct zmk_debounce_slice *slice) {
+    return slice->pressed;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/drivers/led_strip.h>
+
+#define ZMK_LED_HUE_MAX 360
+#define ZMK_LED_SAT_MAX 100
+#define ZMK_LED_BRT_MAX 100
+
+/** Full weight for zmk_led_blend_scale(). */
+#define ZMK_LED_WEIGHT_MAX 256
+
+/**
+ * Converts a hue, saturation and brightness to RGB using only integer math.
+ *
+ * @param h Hue in degrees, 0 to ZMK_LED_HUE_MAX.
+ * @param s Saturation, 0 to ZMK_LED_SAT_MAX.
+ * @param b Brightness, 0 to ZMK_LED_BRT_MAX.
+ */
+struct led_rgb zmk_led_hsb_to_rgb(uint16_t h, uint8_t s, uint8_t b);
+
+/**
+ * Blends two pixel buffers and scales the brightness of the result in a single pass.
+ *
+ * Each output channel is (over * blend + under * (ZMK_LED_WEIGHT_MAX - blend)) * scale, with
+ * blend and scale as fractions of ZMK_LED_WEIGHT_MAX.
+ *
+ * @param out Buffer to write the result to. May be the same as @p over or @p under.
+ * @param over Buffer blended in with weight @p blend.
+ * @param under Buffer blended in with the remaining weight.
+ * @param len Number of pixels in each buffer.
+ * @param blend Weight of @p over, 0 to ZMK_LED_WEIGHT_MAX.
+ * @param scale Brightness of the result, 0 to ZMK_LED_WEIGHT_MAX.
+ */
+void zmk_led_blend_scale(struct led_rgb *out, const struct led_rgb *over,
+                         const struct led_rgb *under, size_t len, uint16_t blend, uint16_t scale);
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/kernel.h>
+
+struct zmk_led_output;
+
+/**
+ * Called from the LED output thread once a frame has been clocked out.
+ *
+ * @param output The output the frame was shown on.
+ * @param err The result of led_strip_update_rgb().
+ */
+typedef void (*zmk_led_output_callback_t)(struct zmk_led_output *output, int err);
+
+/**
+ * Double-buffered output to an LED strip.
+ *
+ * Frames are clocked out on a dedicated thread, so the thread that renders them can go on to the
+ * next frame, or other work, while the strip driver waits for its transfer. Define with
+ * ZMK_LED_OUTPUT_DEFINE() and set up with zmk_led_output_init().
+ */
+struct zmk_led_output {
+    const struct device *strip;
+    zmk_led_output_callback_t callback;
+    size_t num_pixels;
+    struct led_rgb *buffers[2];
+    /* Copy of the last frame submitted, so an unchanged frame is not clocked out again. */
+    struct led_rgb *last;
+    struct k_work work;
+    struct k_spinlock lock;
+    /* Index of the buffer the next frame is copied to. The other one is clocked out. */
+    uint8_t back;
+    /* The back buffer holds a frame that has not been clocked out yet. */
+    bool pending;
+    /* A transfer is in progress or queued. */
+    bool busy;
+    /* last holds a frame the strip shows, or will once it is clocked out. */
+    bool last_valid;
+
+    /*
+     * Frames submitted, skipped because they matched the last one, clocked out, and replaced by a
+     * newer frame before they were shown.
+     */
+    uint32_t frames_submitted;
+    uint32_t frames_unchanged;
+    uint32_t frames_shown;
+    uint32_t frames_dropped;
+};
+
+/**
+ * Statically define a double-buffered output for a strip of @p _num_pixels pixels.
+ */
+#define ZMK_LED_OUTPUT_DEFINE(_name, _num_pixels)                                                  \
+    static struct led_rgb _name##_buffers[3][_num_pixels];                                         \
+    static struct zmk_led_output _name = {                                                         \
+        .num_pixels = (_num_pixels),                                                               \
+        .buffers = {_name##_buffers[0], _name##_buffers[1]},                                       \
+        .last = _name##_buffers[2],                                                                \
+    }
+
+/**
+ * Set up an output to clock its frames out to @p strip.
+ *
+ * @param callback Called once each frame has been clocked out. May be NULL.
+ *
+ * @returns 0 on success, or -ENODEV if the strip is not ready.
+ */
+int zmk_led_output_init(struct zmk_led_output *output, const struct device *strip,
+                        zmk_led_output_callback_t callback);
+
+/**
+ * Queue a frame to be clocked out.
+ *
+ * The frame is copied, so the caller may render the next one into the same buffer right away. If
+ * the previous frame is still waiting for the strip, it is replaced, so the strip always shows
+ * the latest frame and never falls behind the renderer. A frame identical to the last one
+ * submitted is skipped. Safe to call from several threads.
+ *
+ * @param frame Pixels to show, output->num_pixels long.
+ *
+ * @returns 0 on success, or a negative errno if the frame could not be queued.
+ */
+int zmk_led_output_submit(struct zmk_led_output *output, const struct led_rgb *frame);
+
+/**
+ * Forget the last frame submitted, so the next one is clocked out even if it is the same. Use
+ * when the strip may have lost what it showed, such as after it was powered off.
+ */
+void zmk_led_output_invalidate(struct zmk_led_output *output);
@@ -27,15 +27,13 @@ static void decrement_counter(struct zmk_debounce_state *state, const int elapse
     }
 }
 
-void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, const int elapsed_ms,
-                         const struct zmk_debounce_config *config) {
+static void debounce_integrator(struct zmk_debounce_state *state, const bool active,
+                                const int elapsed_ms, const struct zmk_debounce_config *config) {
     // This uses a variation of the integrator debouncing described at
     // https://www.kennethkuhn.com/electronics/debounce.c
     // Every update where "active" does not match the current state, we increment
     // a counter, otherwise we decrement it. When the counter reaches a
     // threshold, the state flips and we reset the counter.
-    state->changed = false;
-
     if (active == state->pressed) {
         decrement_counter(state, elapsed_ms);
         return;
@@ -53,10 +51,71 @@ void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, co
     state->changed = true;
 }
 
+static void debounce_eager_press(struct zmk_debounce_state *state, const bool active,
+                                 const int elapsed_ms, const struct zmk_debounce_config *config) {
+    // Presses flip immediately. While pressed, the counter measures how long the switch has been
+    // released without interruption, and the release is reported once it reaches the threshold.
+    if (!state->pressed || active) {
+        state->changed = active && !state->pressed;
+        state->pressed = state->pressed || active;
+        state->counter = 0;
+        return;
+    }
+
+    if (state->counter < config->debounce_release_ms) {
+        increment_counter(state, elapsed_ms);
+        return;
+    }
+
+    state->pressed = false;
+    state->counter = 0;
+    state->changed = true;
+}
+
+static void debounce_eager(struct zmk_debounce_state *state, const bool active,
+                           const int elapsed_ms, const struct zmk_debounce_config *config) {
+    // Any change flips immediately, then the counter holds off further changes until it has
+    // counted back down to zero.
+    if (state->counter > 0) {
+        decrement_counter(state, elapsed_ms);
+        return;
+    }
+
+    if (active == state->pressed) {
+        return;
+    }
+
+    state->pressed = active;
+    state->counter = active ? config->debounce_press_ms : config->debounce_release_ms;
+    state->changed = true;
+}
+
+void zmk_debounce_update(struct zmk_debounce_state *state, const bool active, const int elapsed_ms,
+                         const struct zmk_debounce_config *config) {
+    state->changed = false;
+
+    switch (config->algorithm) {
+    case ZMK_DEBOUNCE_EAGER_PRESS:
+        debounce_eager_press(state, active, elapsed_ms, config);
+        break;
+    case ZMK_DEBOUNCE_EAGER:
+        debounce_eager(state, active, elapsed_ms, config);
+        break;
+    case ZMK_DEBOUNCE_INTEGRATOR:
+    default:
+        debounce_integrator(state, active, elapsed_ms, config);
+        break;
+    }
+}
+
 bool zmk_debounce_is_active(const struct zmk_debounce_state *state) {
     return state->pressed || state->counter > 0;
 }
 
+bool zmk_debounce_is_settling(const struct zmk_debounce_state *state) {
+    return state->counter > 0;
+}
+
 bool zmk_debounce_is_pressed(const struct zmk_debounce_state *state) { return state->pressed; }
 
 bool zmk_debounce_get_changed(const struct zmk_debounce_state *state) { return state->changed; }
\ No newline at end of file
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zmk/debounce.h>
+
+/**
+ * Bit mask of the lanes whose counter is at least @p value.
+ */
+static uint32_t counter_at_least(const struct zmk_debounce_slice *slice, const uint8_t planes,
+                                 const uint16_t value) {
+    uint32_t greater = 0;
+    uint32_t equal = UINT32_MAX;
+
+    for (int i = planes - 1; i >= 0; i--) {
+        if (value & BIT(i)) {
+            equal &= slice->counter[i];
+        } else {
+            greater |= equal & slice->counter[i];
+            equal &= ~slice->counter[i];
+        }
+    }
+
+    return greater | equal;
+}
+
+static uint32_t counter_nonzero(const struct zmk_debounce_slice *slice, const uint8_t planes) {
+    uint32_t nonzero = 0;
+
+    for (int i = 0; i < planes; i++) {
+        nonzero |= slice->counter[i];
+    }
+
+    return nonzero;
+}
+
+static void counter_increment(struct zmk_debounce_slice *slice, const uint8_t planes,
+                              uint32_t lanes) {
+    for (int i = 0; i < planes && lanes; i++) {
+        const uint32_t carry = slice->counter[i] & lanes;
+        slice->counter[i] ^= lanes;
+        lanes = carry;
+    }
+}
+
+static void counter_decrement(struct zmk_debounce_slice *slice, const uint8_t planes,
+                              uint32_t lanes) {
+    for (int i = 0; i < planes && lanes; i++) {
+        const uint32_t borrow = ~slice->counter[i] & lanes;
+        slice->counter[i] ^= lanes;
+        lanes = borrow;
+    }
+}
+
+static void counter_load(struct zmk_debounce_slice *slice, const uint8_t planes,
+                         const uint32_t lanes, const uint16_t value) {
+    for (int i = 0; i < planes; i++) {
+        slice->counter[i] = (slice->counter[i] & ~lanes) | ((value & BIT(i)) ? lanes : 0);
+    }
+}
+
+static uint32_t update_integrator(struct zmk_debounce_slice *slice, const uint32_t mismatch,
+                                  const struct zmk_debounce_slice_config *config) {
+    // A switch that does not match its latched state counts up until it reaches the threshold
+    // for that state and flips on the next mismatch; one that matches counts back down.
+    const uint8_t planes = config->planes;
+    const uint32_t at_threshold =
+        (slice->pressed & counter_at_least(slice, planes, config->release_scans)) |
+        (~slice->pressed & counter_at_least(slice, planes, config->press_scans));
+
+    const uint32_t flip = mismatch & at_threshold;
+
+    counter_increment(slice, planes, mismatch & ~at_threshold);
+    counter_decrement(slice, planes, ~mismatch & counter_nonzero(slice, planes));
+    counter_load(slice, planes, flip, 0);
+
+    return flip;
+}
+
+static uint32_t update_eager_press(struct zmk_debounce_slice *slice, const uint32_t mismatch,
+                                   const struct zmk_debounce_slice_config *config) {
+    // Released switches flip on the first mismatch. Pressed ones count how long they have been
+    // released and flip on the next mismatch after reaching the threshold. Every other counter
+    // restarts from zero.
+    const uint8_t planes = config->planes;
+    const uint32_t at_threshold =
+        slice->pressed & counter_at_least(slice, planes, config->release_scans);
+
+    const uint32_t flip = mismatch & (~slice->pressed | at_threshold);
+    const uint32_t waiting = mismatch & ~flip;
+
+    counter_increment(slice, planes, waiting);
+    counter_load(slice, planes, ~waiting, 0);
+
+    return flip;
+}
+
+static uint32_t update_eager(struct zmk_debounce_slice *slice, const uint32_t mismatch,
+                             const struct zmk_debounce_slice_config *config) {
+    // Switches with a non-zero counter are held off while it counts down. The rest flip on the
+    // first mismatch and load the hold-off time for their new state.
+    const uint8_t planes = config->planes;
+    const uint32_t holding = counter_nonzero(slice, planes);
+    const uint32_t flip = mismatch & ~holding;
+    const uint32_t pressed = slice->pressed ^ flip;
+
+    counter_decrement(slice, planes, holding);
+    counter_load(slice, planes, flip & pressed, config->press_scans);
+    counter_load(slice, planes, flip & ~pressed, config->release_scans);
+
+    return flip;
+}
+
+uint32_t zmk_debounce_slice_update(struct zmk_debounce_slice *slice, const uint32_t active,
+                                   const struct zmk_debounce_slice_config *config) {
+    const uint32_t mismatch = active ^ slice->pressed;
+
+    if (mismatch == 0 && counter_nonzero(slice, config->planes) == 0) {
+        return 0;
+    }
+
+    uint32_t flip;
+
+    switch (config->algorithm) {
+    case ZMK_DEBOUNCE_EAGER_PRESS:
+        flip = update_eager_press(slice, mismatch, config);
+        break;
+    case ZMK_DEBOUNCE_EAGER:
+        flip = update_eager(slice, mismatch, config);
+        break;
+    case ZMK_DEBOUNCE_INTEGRATOR:
+    default:
+        flip = update_integrator(slice, mismatch, config);
+        break;
+    }
+
+    slice->pressed ^= flip;
+
+    return flip;
+}
+
+uint32_t zmk_debounce_slice_get_active(const struct zmk_debounce_slice *slice,
+                                       const struct zmk_debounce_slice_config *config) {
+    return slice->pressed | counter_nonzero(slice, config->planes);
+}
+
+uint32_t zmk_debounce_slice_get_settling(const struct zmk_debounce_slice *slice,
+                                         const struct zmk_debounce_slice_config *config) {
+    return counter_nonzero(slice, config->planes);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/led_color.h>
+
+#define HUE_SECTOR (ZMK_LED_HUE_MAX / 6)
+
+/* Red and blue, and green, of a pixel packed as 0x00RRGGBB. Each gets a 16 bit lane to scale in. */
+#define PACKED_RB 0x00FF00FF
+#define PACKED_G 0x0000FF00
+
+struct led_rgb zmk_led_hsb_to_rgb(uint16_t h, uint8_t s, uint8_t b) {
+    const uint32_t sector = (h / HUE_SECTOR) % 6;
+    const uint32_t offset = h % HUE_SECTOR;
+
+    // Each channel is b * 255 * (1 - x * s) with x a fraction of the sector, so keep everything
+    // over one common denominator and divide once at the end. The largest numerator is
+    // 100 * 255 * 6000, well within 32 bits.
+    const uint32_t full = (uint32_t)b * 255;
+    const uint32_t den = ZMK_LED_BRT_MAX * ZMK_LED_SAT_MAX * HUE_SECTOR;
+    const uint32_t one = ZMK_LED_SAT_MAX * HUE_SECTOR;
+
+    const uint8_t v = full / ZMK_LED_BRT_MAX;
+    const uint8_t p = full * (one - (uint32_t)s * HUE_SECTOR) / den;
+    const uint8_t q = full * (one - offset * s) / den;
+    const uint8_t t = full * (one - (HUE_SECTOR - offset) * s) / den;
+
+    // Which of v, t, p and q each of red, green and blue takes in each sector of the hue circle.
+    // Looking them up instead of switching keeps a sweep across the hues free of mispredicted
+    // branches.
+    static const uint8_t channels[6][3] = {
+        {0, 1, 2}, {3, 0, 2}, {2, 0, 1}, {2, 3, 0}, {1, 2, 0}, {0, 2, 3},
+    };
+    const uint8_t values[] = {v, t, p, q};
+
+    return (struct led_rgb){
+        r : values[channels[sector][0]],
+        g : values[channels[sector][1]],
+        b : values[channels[sector][2]],
+    };
+}
+
+static inline uint32_t pack(const struct led_rgb *pixel) {
+    return ((uint32_t)pixel->r << 16) | ((uint32_t)pixel->g << 8) | pixel->b;
+}
+
+void zmk_led_blend_scale(struct led_rgb *out, const struct led_rgb *over,
+                         const struct led_rgb *under, size_t len, uint16_t blend, uint16_t scale) {
+    blend = MIN(blend, ZMK_LED_WEIGHT_MAX);
+    scale = MIN(scale, ZMK_LED_WEIGHT_MAX);
+
+    // Fold the brightness into the blend weights, so each pixel takes one multiply per buffer for
+    // red and blue together and one for green. The weights sum to at most 256, so no lane can
+    // carry into the next.
+    const uint32_t over_weight = (blend * scale) >> 8;
+    const uint32_t under_weight = ((ZMK_LED_WEIGHT_MAX - blend) * scale) >> 8;
+
+    for (size_t i = 0; i < len; i++) {
+        const uint32_t o = pack(&over[i]);
+        const uint32_t u = pack(&under[i]);
+
+        const uint32_t rb =
+            (((o & PACKED_RB) * over_weight + (u & PACKED_RB) * under_weight) >> 8) & PACKED_RB;
+        const uint32_t g =
+            (((o & PACKED_G) * over_weight + (u & PACKED_G) * under_weight) >> 8) & PACKED_G;
+
+        out[i].r = rb >> 16;
+        out[i].g = g >> 8;
+        out[i].b = rb;
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+
+#include <zmk/led_output.h>
+
+K_THREAD_STACK_DEFINE(led_output_q_stack, CONFIG_ZMK_LED_OUTPUT_THREAD_STACK_SIZE);
+
+static struct k_work_q led_output_work_q;
+
+static void zmk_led_output_transfer(struct k_work *work) {
+    struct zmk_led_output *output = CONTAINER_OF(work, struct zmk_led_output, work);
+    struct led_rgb *front;
+
+    K_SPINLOCK(&output->lock) {
+        front = output->buffers[output->back];
+        output->back ^= 1;
+        output->pending = false;
+    }
+
+    // Strip drivers wait for their bus transfer to finish, which now only holds up this thread.
+    const int err = led_strip_update_rgb(output->strip, front, output->num_pixels);
+
+    bool again;
+    K_SPINLOCK(&output->lock) {
+        output->frames_shown++;
+        again = output->pending;
+        output->busy = again;
+    }
+
+    if (output->callback) {
+        output->callback(output, err);
+    }
+
+    // A frame submitted during the transfer went to the other buffer, so clock it out next.
+    if (again) {
+        k_work_submit_to_queue(&led_output_work_q, &output->work);
+    }
+}
+
+int zmk_led_output_init(struct zmk_led_output *output, const struct device *strip,
+                        zmk_led_output_callback_t callback) {
+    if (!device_is_ready(strip)) {
+        return -ENODEV;
+    }
+
+    output->strip = strip;
+    output->callback = callback;
+    k_work_init(&output->work, zmk_led_output_transfer);
+
+    return 0;
+}
+
+int zmk_led_output_submit(struct zmk_led_output *output, const struct led_rgb *frame) {
+    if (output->strip == NULL) {
+        return -ENODEV;
+    }
+
+    const size_t size = output->num_pixels * sizeof(struct led_rgb);
+    bool start = false;
+
+    K_SPINLOCK(&output->lock) {
+        output->frames_submitted++;
+
+        // Compared under the lock, so concurrent submits can't leave last out of step with the
+        // frame the strip ends up showing.
+        if (output->last_valid && memcmp(output->last, frame, size) == 0) {
+            output->frames_unchanged++;
+            K_SPINLOCK_BREAK;
+        }
+
+        memcpy(output->last, frame, size);
+        output->last_valid = true;
+
+        // The back buffer is never the one being clocked out, so it can be written while the
+        // strip is busy. The copy is held under the lock so a transfer can't swap buffers midway.
+        memcpy(output->buffers[output->back], frame, size);
+
+        if (output->pending) {
+            output->frames_dropped++;
+        }
+        output->pending = true;
+
+        start = !output->busy;
+        output->busy = true;
+    }
+
+    if (start) {
+        int ret = k_work_submit_to_queue(&led_output_work_q, &output->work);
+        if (ret < 0) {
+            // Nothing will clock the frame out, so don't let later frames wait for it.
+            K_SPINLOCK(&output->lock) {
+                output->busy = false;
+                output->pending = false;
+                output->last_valid = false;
+            }
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+void zmk_led_output_invalidate(struct zmk_led_output *output) {
+    K_SPINLOCK(&output->lock) { output->last_valid = false; }
+}
+
+static int zmk_led_output_work_q_init(void) {
+    static const struct k_work_queue_config queue_config = {.name = "LED Output Work Queue"};
+    k_work_queue_start(&led_output_work_q, led_output_q_stack,
+                       K_THREAD_STACK_SIZEOF(led_output_q_stack),
+                       CONFIG_ZMK_LED_OUTPUT_THREAD_PRIORITY, &queue_config);
+    return 0;
+}
+
+SYS_INIT(zmk_led_output_work_q_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/sys/math_extras.h>
+#include <zephyr/sys/printk.h>
+
+#include <native_rtc.h>
+
+#include <zmk/debounce.h>
+
+#define SCAN_PERIOD_MS 1
+#define PRESS_MS 5
+#define RELEASE_MS 5
+
+#define SCANS 4096
+#define ROUNDS 64
+#define MAX_OUTPUTS 16
+#define MAX_INPUTS 32
+
+static const struct zmk_debounce_config config = {
+    .algorithm = ZMK_DEBOUNCE_INTEGRATOR,
+    .debounce_press_ms = PRESS_MS,
+    .debounce_release_ms = RELEASE_MS,
+};
+
+static const struct zmk_debounce_slice_config slice_config =
+    ZMK_DEBOUNCE_SLICE_CONFIG(ZMK_DEBOUNCE_INTEGRATOR, PRESS_MS, RELEASE_MS, SCAN_PERIOD_MS);
+
+/** Raw input read for each output, one bit per input, for every scan of the run. */
+static uint32_t waveform[SCANS][MAX_OUTPUTS];
+
+static struct zmk_debounce_state key_state[MAX_OUTPUTS * MAX_INPUTS];
+static struct zmk_debounce_slice slice_state[MAX_OUTPUTS];
+
+static volatile uint32_t sink;
+
+/**
+ * Fill the waveform with a few keys being pressed and released, each edge bouncing for a couple
+ * of scans, the way a fast typist on a real matrix would look.
+ */
+static void generate_waveform(const int outputs, const int inputs) {
+    uint32_t held[MAX_OUTPUTS] = {0};
+
+    for (int scan = 0; scan < SCANS; scan++) {
+        if (sys_rand32_get() % 8 == 0) {
+            const int o = sys_rand32_get() % outputs;
+            held[o] ^= BIT(sys_rand32_get() % inputs);
+        }
+
+        for (int o = 0; o < outputs; o++) {
+            uint32_t bounce = 0;
+            if (scan > 0 && (waveform[scan - 1][o] ^ held[o])) {
+                bounce = sys_rand32_get() & (waveform[scan - 1][o] ^ held[o]);
+            }
+            waveform[scan][o] = held[o] ^ bounce;
+        }
+    }
+}
+
+static uint32_t run_per_key(const int outputs, const int inputs) {
+    uint32_t events = 0;
+
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (int o = 0; o < outputs; o++) {
+            for (int i = 0; i < inputs; i++) {
+                zmk_debounce_update(&key_state[o * inputs + i], waveform[scan][o] & BIT(i),
+                                    SCAN_PERIOD_MS, &config);
+            }
+        }
+
+        bool continue_scan = false;
+        for (int o = 0; o < outputs; o++) {
+            for (int i = 0; i < inputs; i++) {
+                const struct zmk_debounce_state *state = &key_state[o * inputs + i];
+                if (zmk_debounce_get_changed(state)) {
+                    events += zmk_debounce_is_pressed(state) ? 1 : 0x10000;
+                }
+                continue_scan = continue_scan || zmk_debounce_is_active(state);
+            }
+        }
+        sink = continue_scan;
+    }
+
+    return events;
+}
+
+static uint32_t run_sliced(const int outputs) {
+    uint32_t events = 0;
+    uint32_t changed[MAX_OUTPUTS];
+
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (int o = 0; o < outputs; o++) {
+            changed[o] =
+                zmk_debounce_slice_update(&slice_state[o], waveform[scan][o], &slice_config);
+        }
+
+        bool continue_scan = false;
+        for (int o = 0; o < outputs; o++) {
+            for (uint32_t c = changed[o]; c; c &= c - 1) {
+                const int lane = u32_count_trailing_zeros(c);
+                events += (slice_state[o].pressed & BIT(lane)) ? 1 : 0x10000;
+            }
+            continue_scan =
+                continue_scan || zmk_debounce_slice_get_active(&slice_state[o], &slice_config);
+        }
+        sink = continue_scan;
+    }
+
+    return events;
+}
+
+static void benchmark(const char *name, const int outputs, const int inputs) {
+    uint64_t per_key_us = 0;
+    uint64_t sliced_us = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        generate_waveform(outputs, inputs);
+        memset(key_state, 0, sizeof(key_state));
+        memset(slice_state, 0, sizeof(slice_state));
+
+        uint64_t start = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+        const uint32_t per_key_events = run_per_key(outputs, inputs);
+        uint64_t end = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+        per_key_us += end - start;
+
+        start = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+        const uint32_t sliced_events = run_sliced(outputs);
+        end = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+        sliced_us += end - start;
+
+        if (per_key_events != sliced_events) {
+            printk("%s: debouncers disagree (%x != %x)\n", name, per_key_events, sliced_events);
+            return;
+        }
+    }
+
+    const uint64_t scans = (uint64_t)SCANS * ROUNDS;
+
+    printk("%s: per-key %llu ns/scan, bit-sliced %llu ns/scan\n", name,
+           (unsigned long long)(per_key_us * 1000 / scans),
+           (unsigned long long)(sliced_us * 1000 / scans));
+}
+
+int main(void) {
+    benchmark("8x16", 8, 16);
+    benchmark("14x6", 6, 14);
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include <zmk/led_color.h>
+#include <zmk/led_output.h>
+
+#define STRIP DT_NODELABEL(strip)
+#define STRIP_NUM_PIXELS DT_PROP(STRIP, chain_length)
+
+#define FRAMES 400
+#define FRAME_PERIOD_MS 25
+
+static const struct device *const strip = DEVICE_DT_GET(STRIP);
+
+ZMK_LED_OUTPUT_DEFINE(output, STRIP_NUM_PIXELS);
+
+/* Stands in for ZMK's low priority work queue, which renders the underglow. */
+K_THREAD_STACK_DEFINE(render_q_stack, 1024);
+static struct k_work_q render_q;
+
+static struct led_rgb frame[STRIP_NUM_PIXELS];
+static uint16_t step;
+static bool double_buffered;
+
+struct stats {
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+/* How long other work queued behind a frame waits, and how far apart frames reach the strip. */
+static struct stats probe_wait;
+static struct stats frame_interval;
+static int64_t probe_submitted_ticks;
+static int64_t last_shown_ticks;
+
+static void stats_add(struct stats *stats, uint32_t us) {
+    stats->min_us = stats->count == 0 ? us : MIN(stats->min_us, us);
+    stats->max_us = MAX(stats->max_us, us);
+    stats->total_us += us;
+    stats->count++;
+}
+
+static uint32_t ticks_to_us(int64_t ticks) { return k_ticks_to_us_floor64(ticks); }
+
+static void frame_shown(void) {
+    const int64_t now = k_uptime_ticks();
+
+    if (last_shown_ticks != 0) {
+        stats_add(&frame_interval, ticks_to_us(now - last_shown_ticks));
+    }
+    last_shown_ticks = now;
+}
+
+static void output_done(struct zmk_led_output *output, int err) { frame_shown(); }
+
+/** Renders a swirl frame and sends it to the strip, the way the underglow tick does. */
+static void render(struct k_work *work) {
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        const uint16_t h = (ZMK_LED_HUE_MAX / STRIP_NUM_PIXELS * i + step) % ZMK_LED_HUE_MAX;
+        frame[i] = zmk_led_hsb_to_rgb(h, 100, 80);
+    }
+    step = (step + 2) % ZMK_LED_HUE_MAX;
+
+    if (double_buffered) {
+        zmk_led_output_submit(&output, frame);
+    } else {
+        led_strip_update_rgb(strip, frame, STRIP_NUM_PIXELS);
+        frame_shown();
+    }
+}
+
+K_WORK_DEFINE(render_work, render);
+
+static void probe(struct k_work *work) {
+    stats_add(&probe_wait, ticks_to_us(k_uptime_ticks() - probe_submitted_ticks));
+}
+
+K_WORK_DEFINE(probe_work, probe);
+
+static void run(const char *name, bool buffered) {
+    probe_wait = (struct stats){0};
+    frame_interval = (struct stats){0};
+    last_shown_ticks = 0;
+    double_buffered = buffered;
+
+    int64_t next = k_uptime_ticks();
+    for (int i = 0; i < FRAMES; i++) {
+        k_work_submit_to_queue(&render_q, &render_work);
+
+        // Other low priority work that arrives just after a frame was queued.
+        probe_submitted_ticks = k_uptime_ticks();
+        k_work_submit_to_queue(&render_q, &probe_work);
+
+        next += k_ms_to_ticks_ceil64(FRAME_PERIOD_MS);
+        k_sleep(K_TIMEOUT_ABS_TICKS(next));
+    }
+
+    printk("%s: other work waited mean %llu us, max %u us; frames every %u to %u us\n", name,
+           (unsigned long long)(probe_wait.total_us / MAX(probe_wait.count, 1)), probe_wait.max_us,
+           frame_interval.min_us, frame_interval.max_us);
+}
+
+int main(void) {
+    int err = zmk_led_output_init(&output, strip, output_done);
+    if (err < 0) {
+        printk("Failed to set up the LED output (%d)\n", err);
+        return err;
+    }
+
+    k_work_queue_start(&render_q, render_q_stack, K_THREAD_STACK_SIZEOF(render_q_stack), 10,
+                       NULL);
+
+    run("direct", false);
+    run("double-buffered", true);
+
+    printk("double-buffered: %u frames submitted, %u shown, %u replaced before they were shown\n",
+           output.frames_submitted, output.frames_shown, output.frames_dropped);
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+# Copyright (c) 2024 The ZMK Contributors
+# SPDX-License-Identifier: MIT
+"""Generate a synthetic key log for the zmk,kscan-replay driver.
+
+The log imitates a fast typist on a 4x12 grid: keys are held for 40-120 ms and the next key is
+often pressed before the previous one is released.
+"""
+
+import argparse
+import heapq
+import random
+
+ROWS = 4
+COLUMNS = 12
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--events", type=int, default=50000, help="number of events to write")
+    parser.add_argument("--seed", type=int, default=0, help="random seed")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+
+    print("# <delay-us> <row> <column> <pressed>")
+
+    now = 0
+    last = 0
+    held = set()
+    releases = []
+    written = 0
+
+    while written < args.events:
+        press_at = now + rng.randint(30_000, 150_000)
+
+        while releases and releases[0][0] <= press_at and written < args.events:
+            at, row, column = heapq.heappop(releases)
+            held.discard((row, column))
+            print(f"{at - last} {row} {column} 0")
+            last = at
+            written += 1
+
+        if written >= args.events:
+            break
+
+        now = press_at
+        row, column = rng.randrange(ROWS), rng.randrange(COLUMNS)
+        if (row, column) in held:
+            continue
+
+        held.add((row, column))
+        heapq.heappush(releases, (now + rng.randint(40_000, 120_000), row, column))
+        print(f"{now - last} {row} {column} 1")
+        last = now
+        written += 1
+
+
+if __name__ == "__main__":
+    main()
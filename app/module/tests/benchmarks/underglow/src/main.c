@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include <native_rtc.h>
+
+#include <zmk/led_color.h>
+
+/* chain-length of the Glove80 underglow strip on each half. */
+#define STRIP_NUM_PIXELS 40
+
+#define FRAMES 100000
+
+static struct led_rgb pixels[STRIP_NUM_PIXELS];
+static struct led_rgb status_pixels[STRIP_NUM_PIXELS];
+static struct led_rgb float_buffer[STRIP_NUM_PIXELS];
+static struct led_rgb integer_buffer[STRIP_NUM_PIXELS];
+
+/** The floating point conversion the underglow renderer used before, for comparison. */
+static struct led_rgb float_hsb_to_rgb(uint16_t h, uint8_t s_in, uint8_t b_in) {
+    float r, g, b;
+
+    uint8_t i = h / 60;
+    float v = b_in / ((float)ZMK_LED_BRT_MAX);
+    float s = s_in / ((float)ZMK_LED_SAT_MAX);
+    float f = h / ((float)ZMK_LED_HUE_MAX) * 6 - i;
+    float p = v * (1 - s);
+    float q = v * (1 - f * s);
+    float t = v * (1 - (1 - f) * s);
+
+    switch (i % 6) {
+    case 0:
+        r = v, g = t, b = p;
+        break;
+    case 1:
+        r = q, g = v, b = p;
+        break;
+    case 2:
+        r = p, g = v, b = t;
+        break;
+    case 3:
+        r = p, g = q, b = v;
+        break;
+    case 4:
+        r = t, g = p, b = v;
+        break;
+    default:
+        r = v, g = p, b = q;
+        break;
+    }
+
+    return (struct led_rgb){r : r * 255, g : g * 255, b : b * 255};
+}
+
+/** The per-channel blend and separate dimming pass the underglow renderer used before. */
+static void float_render(const int step, const uint16_t blend) {
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        const uint16_t h = (ZMK_LED_HUE_MAX / STRIP_NUM_PIXELS * i + step) % ZMK_LED_HUE_MAX;
+        pixels[i] = float_hsb_to_rgb(h, 100, 80);
+    }
+
+    const uint16_t blend_l = blend;
+    const uint16_t blend_r = 256 - blend;
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        float_buffer[i].r = ((status_pixels[i].r * blend_l) >> 8) + ((pixels[i].r * blend_r) >> 8);
+        float_buffer[i].g = ((status_pixels[i].g * blend_l) >> 8) + ((pixels[i].g * blend_r) >> 8);
+        float_buffer[i].b = ((status_pixels[i].b * blend_l) >> 8) + ((pixels[i].b * blend_r) >> 8);
+    }
+
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        float_buffer[i].r = float_buffer[i].r >> 1;
+        float_buffer[i].g = float_buffer[i].g >> 1;
+        float_buffer[i].b = float_buffer[i].b >> 1;
+    }
+}
+
+static void integer_render(const int step, const uint16_t blend) {
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        const uint16_t h = (ZMK_LED_HUE_MAX / STRIP_NUM_PIXELS * i + step) % ZMK_LED_HUE_MAX;
+        pixels[i] = zmk_led_hsb_to_rgb(h, 100, 80);
+    }
+
+    zmk_led_blend_scale(integer_buffer, status_pixels, pixels, STRIP_NUM_PIXELS, blend,
+                        ZMK_LED_WEIGHT_MAX / 2);
+}
+
+static int max_difference(void) {
+    int max = 0;
+
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        max = MAX(max, abs(float_buffer[i].r - integer_buffer[i].r));
+        max = MAX(max, abs(float_buffer[i].g - integer_buffer[i].g));
+        max = MAX(max, abs(float_buffer[i].b - integer_buffer[i].b));
+    }
+
+    return max;
+}
+
+int main(void) {
+    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
+        status_pixels[i] = (struct led_rgb){r : 0xff, g : 0x88 * (i % 2), b : 0xce * (i % 3 == 0)};
+    }
+
+    // Renders a swirl frame blended with a fading status overlay at low battery brightness, the
+    // most work the underglow renderer does in one tick.
+    uint64_t start = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+    for (int frame = 0; frame < FRAMES; frame++) {
+        float_render(frame % ZMK_LED_HUE_MAX, frame % 257);
+    }
+    uint64_t float_us = native_rtc_gettime_us(RTC_CLOCK_REALTIME) - start;
+
+    start = native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+    for (int frame = 0; frame < FRAMES; frame++) {
+        integer_render(frame % ZMK_LED_HUE_MAX, frame % 257);
+    }
+    uint64_t integer_us = native_rtc_gettime_us(RTC_CLOCK_REALTIME) - start;
+
+    int difference = 0;
+    for (int frame = 0; frame < ZMK_LED_HUE_MAX; frame++) {
+        float_render(frame, frame % 257);
+        integer_render(frame, frame % 257);
+        difference = MAX(difference, max_difference());
+    }
+
+    printk("%d pixels: float %llu ns/frame, integer %llu ns/frame, max channel difference %d\n",
+           STRIP_NUM_PIXELS, (unsigned long long)(float_us * 1000 / FRAMES),
+           (unsigned long long)(integer_us * 1000 / FRAMES), difference);
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include <zmk/debounce.h>
+
+#define SCAN_PERIOD_MS 1
+#define DEBOUNCE_MS 5
+#define MAX_EVENTS 4
+
+/**
+ * Switch waveforms sampled once per scan period. Each one starts released and ends released.
+ */
+enum waveform {
+    /** A clean press and release with no bounce. */
+    WAVEFORM_CLEAN,
+    /** Contact bounce on both the press and the release. */
+    WAVEFORM_BOUNCY,
+    /** A single-scan noise spike. */
+    WAVEFORM_SPIKE,
+    WAVEFORM_COUNT,
+};
+
+static const char *const waveforms[WAVEFORM_COUNT] = {
+    [WAVEFORM_CLEAN] = "0000111111111100000000000000",
+    [WAVEFORM_BOUNCY] = "000101101111111111111010010000000000000000",
+    [WAVEFORM_SPIKE] = "0000010000000000000000",
+};
+
+struct debounce_event {
+    bool pressed;
+    int scan;
+};
+
+struct debounce_result {
+    struct debounce_event events[MAX_EVENTS];
+    int count;
+};
+
+/** Scans at which each algorithm is expected to report changes for each waveform. */
+static const struct debounce_result expected[][WAVEFORM_COUNT] = {
+    [ZMK_DEBOUNCE_INTEGRATOR] =
+        {
+            [WAVEFORM_CLEAN] = {.events = {{true, 9}, {false, 19}}, .count = 2},
+            [WAVEFORM_BOUNCY] = {.events = {{true, 12}, {false, 30}}, .count = 2},
+            [WAVEFORM_SPIKE] = {.count = 0},
+        },
+    [ZMK_DEBOUNCE_EAGER_PRESS] =
+        {
+            [WAVEFORM_CLEAN] = {.events = {{true, 4}, {false, 19}}, .count = 2},
+            [WAVEFORM_BOUNCY] = {.events = {{true, 3}, {false, 31}}, .count = 2},
+            [WAVEFORM_SPIKE] = {.events = {{true, 5}, {false, 11}}, .count = 2},
+        },
+    [ZMK_DEBOUNCE_EAGER] =
+        {
+            [WAVEFORM_CLEAN] = {.events = {{true, 4}, {false, 14}}, .count = 2},
+            [WAVEFORM_BOUNCY] = {.events = {{true, 3}, {false, 21}}, .count = 2},
+            [WAVEFORM_SPIKE] = {.events = {{true, 5}, {false, 11}}, .count = 2},
+        },
+};
+
+static const char *const algorithm_names[] = {
+    [ZMK_DEBOUNCE_INTEGRATOR] = "integrator",
+    [ZMK_DEBOUNCE_EAGER_PRESS] = "eager-press",
+    [ZMK_DEBOUNCE_EAGER] = "eager",
+};
+
+static void record_event(struct debounce_result *result, const bool pressed, const int scan) {
+    zassert_true(result->count < MAX_EVENTS, "Too many events at scan %d", scan);
+
+    result->events[result->count++] = (struct debounce_event){.pressed = pressed, .scan = scan};
+}
+
+static void replay(const enum zmk_debounce_algorithm algorithm, const char *waveform,
+                   struct debounce_result *result) {
+    const struct zmk_debounce_config config = {
+        .algorithm = algorithm,
+        .debounce_press_ms = DEBOUNCE_MS,
+        .debounce_release_ms = DEBOUNCE_MS,
+    };
+    struct zmk_debounce_state state = {0};
+
+    for (int scan = 0; waveform[scan] != '\0'; scan++) {
+        zmk_debounce_update(&state, waveform[scan] == '1', SCAN_PERIOD_MS, &config);
+
+        if (zmk_debounce_get_changed(&state)) {
+            record_event(result, zmk_debounce_is_pressed(&state), scan);
+        }
+    }
+
+    zassert_false(zmk_debounce_is_active(&state), "%s did not settle", algorithm_names[algorithm]);
+}
+
+/**
+ * Replays every waveform at once, one per lane of a slice, so the lanes also check that
+ * switches are debounced independently.
+ */
+static void replay_sliced(const enum zmk_debounce_algorithm algorithm,
+                          struct debounce_result results[WAVEFORM_COUNT]) {
+    const struct zmk_debounce_slice_config config =
+        ZMK_DEBOUNCE_SLICE_CONFIG(algorithm, DEBOUNCE_MS, DEBOUNCE_MS, SCAN_PERIOD_MS);
+    struct zmk_debounce_slice slice = {0};
+    size_t scans = 0;
+
+    for (int w = 0; w < WAVEFORM_COUNT; w++) {
+        scans = MAX(scans, strlen(waveforms[w]));
+    }
+
+    for (int scan = 0; scan < scans; scan++) {
+        uint32_t active = 0;
+
+        for (int w = 0; w < WAVEFORM_COUNT; w++) {
+            if (scan < strlen(waveforms[w]) && waveforms[w][scan] == '1') {
+                active |= BIT(w);
+            }
+        }
+
+        const uint32_t changed = zmk_debounce_slice_update(&slice, active, &config);
+
+        for (int w = 0; w < WAVEFORM_COUNT; w++) {
+            if (changed & BIT(w)) {
+                record_event(&results[w], zmk_debounce_slice_get_pressed(&slice) & BIT(w), scan);
+            }
+        }
+    }
+
+    zassert_equal(zmk_debounce_slice_get_active(&slice, &config), 0, "%s did not settle",
+                  algorithm_names[algorithm]);
+}
+
+static void assert_result(const enum zmk_debounce_algorithm algorithm, const enum waveform w,
+                          const struct debounce_result *actual) {
+    const struct debounce_result *exp = &expected[algorithm][w];
+
+    zassert_equal(actual->count, exp->count, "%s waveform %d: expected %d events, got %d",
+                  algorithm_names[algorithm], w, exp->count, actual->count);
+
+    for (int i = 0; i < exp->count; i++) {
+        zassert_equal(actual->events[i].pressed, exp->events[i].pressed,
+                      "%s waveform %d event %d has the wrong state", algorithm_names[algorithm],
+                      w, i);
+        zassert_equal(actual->events[i].scan, exp->events[i].scan,
+                      "%s waveform %d event %d: expected scan %d, got %d",
+                      algorithm_names[algorithm], w, i, exp->events[i].scan,
+                      actual->events[i].scan);
+    }
+}
+
+/**
+ * Latency from the first edge of each transition of the clean waveform to its report.
+ */
+static void assert_latency(const enum zmk_debounce_algorithm algorithm,
+                           const struct debounce_result *clean, const int press_latency_ms,
+                           const int release_latency_ms) {
+    const char *waveform = waveforms[WAVEFORM_CLEAN];
+    const int press_edge = strchr(waveform, '1') - waveform;
+    const int release_edge = strrchr(waveform, '1') - waveform + 1;
+
+    const int press_ms = (clean->events[0].scan - press_edge) * SCAN_PERIOD_MS;
+    const int release_ms = (clean->events[1].scan - release_edge) * SCAN_PERIOD_MS;
+
+    TC_PRINT("%s: press latency %d ms, release latency %d ms\n", algorithm_names[algorithm],
+             press_ms, release_ms);
+
+    zassert_equal(press_ms, press_latency_ms);
+    zassert_equal(release_ms, release_latency_ms);
+}
+
+static void test_algorithm(const enum zmk_debounce_algorithm algorithm, const int press_latency_ms,
+                           const int release_latency_ms) {
+    struct debounce_result sliced[WAVEFORM_COUNT] = {0};
+
+    replay_sliced(algorithm, sliced);
+
+    for (int w = 0; w < WAVEFORM_COUNT; w++) {
+        struct debounce_result result = {0};
+
+        replay(algorithm, waveforms[w], &result);
+
+        assert_result(algorithm, w, &result);
+        assert_result(algorithm, w, &sliced[w]);
+
+        if (w == WAVEFORM_CLEAN) {
+            assert_latency(algorithm, &result, press_latency_ms, release_latency_ms);
+        }
+    }
+}
+
+ZTEST(debounce, test_integrator) {
+    test_algorithm(ZMK_DEBOUNCE_INTEGRATOR, DEBOUNCE_MS, DEBOUNCE_MS);
+}
+
+ZTEST(debounce, test_eager_press) { test_algorithm(ZMK_DEBOUNCE_EAGER_PRESS, 0, DEBOUNCE_MS); }
+
+ZTEST(debounce, test_eager) { test_algorithm(ZMK_DEBOUNCE_EAGER, 0, 0); }
+
+ZTEST_SUITE(debounce, NULL, NULL, NULL, NULL, NULL);
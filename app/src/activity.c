@@ -19,6 +19,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/events/activity_state_changed.h>
 #include <zmk/events/position_state_changed.h>
 #include <zmk/events/sensor_event.h>
+#include <zmk/events/usb_conn_state_changed.h>
 
 #include <zmk/activity.h>
 
@@ -93,7 +94,10 @@ bool is_usb_power_present(void) {
 
 static enum zmk_activity_state activity_state;
 
-static uint32_t activity_last_uptime;
+static int64_t activity_last_uptime;
+
+/* Times the deadline work has run, to confirm nothing wakes the CPU while idle. */
+static uint32_t activity_wakeups;
 
 #define MAX_IDLE_MS CONFIG_ZMK_IDLE_TIMEOUT
 
@@ -116,49 +120,90 @@ int set_state(enum zmk_activity_state state) {
 
 enum zmk_activity_state zmk_activity_get_state(void) { return activity_state; }
 
+void activity_work_handler(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(activity_work, activity_work_handler);
+
+/**
+ * Arm the deadline work for the next state transition that is still ahead, or leave it unarmed
+ * if there is none, so nothing wakes the CPU until the next activity.
+ */
+static void activity_schedule(int64_t inactive_time) {
+    int64_t next = INT64_MAX;
+
+    if (inactive_time < MAX_IDLE_MS) {
+        next = MAX_IDLE_MS;
+    }
+#if IS_ENABLED(CONFIG_ZMK_SLEEP)
+    if (inactive_time < MAX_SLEEP_MS) {
+        next = MIN(next, MAX_SLEEP_MS);
+    }
+#endif /* IS_ENABLED(CONFIG_ZMK_SLEEP) */
+
+    if (next != INT64_MAX) {
+        k_work_reschedule(&activity_work, K_TIMEOUT_ABS_MS(activity_last_uptime + next));
+    }
+}
+
 int activity_event_listener(const zmk_event_t *eh) {
+#if IS_ENABLED(CONFIG_ZMK_SLEEP) && IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+    if (as_zmk_usb_conn_state_changed(eh)) {
+        // Sleep waits while USB power is present, so check again once it may have gone.
+        k_work_reschedule(&activity_work, K_NO_WAIT);
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+#endif
+
     activity_last_uptime = k_uptime_get();
+    activity_schedule(0);
 
     return set_state(ZMK_ACTIVITY_ACTIVE);
 }
 
 void activity_work_handler(struct k_work *work) {
-    int32_t current = k_uptime_get();
-    int32_t inactive_time = current - activity_last_uptime;
+    int64_t current = k_uptime_get();
+    int64_t inactive_time = current - activity_last_uptime;
+
+    activity_wakeups++;
+    LOG_DBG("Activity check %u, %u per hour", activity_wakeups,
+            (uint32_t)(activity_wakeups * 3600000LL / MAX(current, 1)));
+
 #if IS_ENABLED(CONFIG_ZMK_SLEEP)
-    if (inactive_time > MAX_SLEEP_MS && !is_usb_power_present()) {
+    if (inactive_time >= MAX_SLEEP_MS && !is_usb_power_present()) {
         // Put devices in suspend power mode before sleeping
         set_state(ZMK_ACTIVITY_SLEEP);
 
         if (zmk_pm_suspend_devices() < 0) {
             LOG_ERR("Failed to suspend all the devices");
             zmk_pm_resume_devices();
+            // Nothing else would wake the check up again, so retry in a second.
+            k_work_reschedule(&activity_work, K_SECONDS(1));
             return;
         }
 
         sys_poweroff();
-    } else
+    }
 #endif /* IS_ENABLED(CONFIG_ZMK_SLEEP) */
-        if (inactive_time > MAX_IDLE_MS) {
-            set_state(ZMK_ACTIVITY_IDLE);
-        }
-}
-
-K_WORK_DEFINE(activity_work, activity_work_handler);
 
-void activity_expiry_function(struct k_timer *_timer) { k_work_submit(&activity_work); }
+    if (inactive_time >= MAX_IDLE_MS) {
+        set_state(ZMK_ACTIVITY_IDLE);
+    }
 
-K_TIMER_DEFINE(activity_timer, activity_expiry_function, NULL);
+    activity_schedule(inactive_time);
+}
 
 static int activity_init(void) {
     activity_last_uptime = k_uptime_get();
+    activity_schedule(0);
 
-    k_timer_start(&activity_timer, K_SECONDS(1), K_SECONDS(1));
     return 0;
 }
 
 ZMK_LISTENER(activity, activity_event_listener);
 ZMK_SUBSCRIPTION(activity, zmk_position_state_changed);
 ZMK_SUBSCRIPTION(activity, zmk_sensor_event);
+#if IS_ENABLED(CONFIG_ZMK_SLEEP) && IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+ZMK_SUBSCRIPTION(activity, zmk_usb_conn_state_changed);
+#endif
 
 SYS_INIT(activity_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdlib.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/init.h>
@@ -34,13 +35,26 @@ static const struct device *const battery = DEVICE_DT_GET(DT_CHOSEN(zmk_battery)
 static const struct device *battery;
 #endif
 
-static int zmk_battery_update(const struct device *battery) {
+// Fractional bits kept in the smoothed level, so that small steps aren't lost to rounding.
+#define BATTERY_FRACTION_BITS 8
+
+static uint8_t samples[CONFIG_ZMK_BATTERY_SAMPLES];
+static uint8_t sample_count;
+
+static int32_t smoothed_state_of_charge;
+static bool reported;
+
+static atomic_t reporting;
+
+static int zmk_battery_sample(const struct device *battery) {
     struct sensor_value state_of_charge;
 
     int rc = sensor_sample_fetch_chan(battery, SENSOR_CHAN_GAUGE_STATE_OF_CHARGE);
 
     if (rc != 0) {
-        LOG_DBG("Failed to fetch battery values: %d", rc);
+        if (rc != -EAGAIN) {
+            LOG_DBG("Failed to fetch battery values: %d", rc);
+        }
         return rc;
     }
 
@@ -51,47 +65,113 @@ static int zmk_battery_update(const struct device *battery) {
         return rc;
     }
 
-    if (last_state_of_charge != state_of_charge.val1) {
-        last_state_of_charge = state_of_charge.val1;
-#if IS_ENABLED(CONFIG_BT_BAS)
-        LOG_DBG("Setting BAS GATT battery level to %d.", last_state_of_charge);
+    samples[sample_count++] = state_of_charge.val1;
 
-        rc = bt_bas_set_battery_level(last_state_of_charge);
+    return 0;
+}
+
+static uint8_t zmk_battery_median(void) {
+    for (int i = 1; i < sample_count; i++) {
+        const uint8_t sample = samples[i];
+        int j = i;
 
-        if (rc != 0) {
-            LOG_WRN("Failed to set BAS GATT battery level (err %d)", rc);
-            return rc;
+        for (; j > 0 && samples[j - 1] > sample; j--) {
+            samples[j] = samples[j - 1];
         }
-#endif
-        rc = raise_zmk_battery_state_changed(
-            (struct zmk_battery_state_changed){.state_of_charge = last_state_of_charge});
+        samples[j] = sample;
     }
 
+    return samples[sample_count / 2];
+}
+
+static int zmk_battery_update(uint8_t state_of_charge) {
+    const int32_t sample = state_of_charge << BATTERY_FRACTION_BITS;
+
+    if (reported) {
+        smoothed_state_of_charge +=
+            (sample - smoothed_state_of_charge) * CONFIG_ZMK_BATTERY_SMOOTHING_WEIGHT / 100;
+    } else {
+        smoothed_state_of_charge = sample;
+    }
+
+    const uint8_t level = (smoothed_state_of_charge + BIT(BATTERY_FRACTION_BITS - 1)) >>
+                          BATTERY_FRACTION_BITS;
+
+    if (reported && level == last_state_of_charge) {
+        return 0;
+    }
+
+    // Small moves are held back so the level doesn't flicker, except on reaching empty or full.
+    if (reported && abs(level - last_state_of_charge) < CONFIG_ZMK_BATTERY_HYSTERESIS &&
+        level != 0 && level != 100) {
+        return 0;
+    }
+
+    last_state_of_charge = level;
+    reported = true;
+
+    int rc = 0;
+#if IS_ENABLED(CONFIG_BT_BAS)
+    LOG_DBG("Setting BAS GATT battery level to %d.", last_state_of_charge);
+
+    rc = bt_bas_set_battery_level(last_state_of_charge);
+
+    if (rc != 0) {
+        LOG_WRN("Failed to set BAS GATT battery level (err %d)", rc);
+        return rc;
+    }
+#endif
+    rc = raise_zmk_battery_state_changed(
+        (struct zmk_battery_state_changed){.state_of_charge = last_state_of_charge});
+
     return rc;
 }
 
+static void zmk_battery_work(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(battery_work, zmk_battery_work);
+
 static void zmk_battery_work(struct k_work *work) {
-    int rc = zmk_battery_update(battery);
+    // Reporting stopped since this was scheduled. Finish a reading in progress, so a voltage
+    // divider isn't left powered, but don't start a new one.
+    if (sample_count == 0 && !atomic_get(&reporting)) {
+        return;
+    }
+
+    int rc = zmk_battery_sample(battery);
+
+    // Come back shortly rather than waiting here while the sensor settles, or for the next sample.
+    if (rc == -EAGAIN || (rc == 0 && sample_count < CONFIG_ZMK_BATTERY_SAMPLES)) {
+        k_work_schedule_for_queue(zmk_workqueue_lowprio_work_q(), &battery_work,
+                                  K_MSEC(CONFIG_ZMK_BATTERY_SAMPLE_SPACING_MS));
+        return;
+    }
+
+    if (rc == 0) {
+        rc = zmk_battery_update(zmk_battery_median());
+    }
 
     if (rc != 0) {
         LOG_DBG("Failed to update battery value: %d.", rc);
     }
-}
 
-K_WORK_DEFINE(battery_work, zmk_battery_work);
+    sample_count = 0;
 
-static void zmk_battery_timer(struct k_timer *timer) {
-    k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &battery_work);
+    if (atomic_get(&reporting)) {
+        k_work_schedule_for_queue(zmk_workqueue_lowprio_work_q(), &battery_work,
+                                  K_SECONDS(CONFIG_ZMK_BATTERY_REPORT_INTERVAL));
+    }
 }
 
-K_TIMER_DEFINE(battery_timer, zmk_battery_timer, NULL);
-
 static void zmk_battery_start_reporting() {
     if (device_is_ready(battery)) {
-        k_timer_start(&battery_timer, K_NO_WAIT, K_SECONDS(CONFIG_ZMK_BATTERY_REPORT_INTERVAL));
+        atomic_set(&reporting, true);
+        k_work_reschedule_for_queue(zmk_workqueue_lowprio_work_q(), &battery_work, K_NO_WAIT);
     }
 }
 
+static void zmk_battery_stop_reporting() { atomic_set(&reporting, false); }
+
 static int zmk_battery_init(void) {
 #if !DT_HAS_CHOSEN(zmk_battery)
     battery = device_get_binding("BATTERY");
@@ -121,7 +201,7 @@ static int battery_event_listener(const zmk_event_t *eh) {
             return 0;
         case ZMK_ACTIVITY_IDLE:
         case ZMK_ACTIVITY_SLEEP:
-            k_timer_stop(&battery_timer);
+            zmk_battery_stop_reporting();
             return 0;
         default:
             break;
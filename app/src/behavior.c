@@ -39,6 +39,83 @@ const struct device *z_impl_behavior_get_binding(const char *name) {
     return NULL;
 }
 
+static const struct zmk_behavior_local_id_map *
+behavior_find_local_id(zmk_behavior_local_id_t local_id) {
+    ptrdiff_t count;
+    STRUCT_SECTION_COUNT(zmk_behavior_local_id_map, &count);
+
+    ptrdiff_t low = 0, high = count;
+    while (low < high) {
+        const ptrdiff_t mid = low + (high - low) / 2;
+        struct zmk_behavior_local_id_map *item;
+        STRUCT_SECTION_GET(zmk_behavior_local_id_map, mid, &item);
+
+        if (item->local_id == local_id) {
+            return item;
+        } else if (item->local_id < local_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+const char *zmk_behavior_find_behavior_name_from_local_id(zmk_behavior_local_id_t local_id) {
+    const struct zmk_behavior_local_id_map *item = behavior_find_local_id(local_id);
+
+    return item ? item->device->name : NULL;
+}
+
+const struct device *zmk_behavior_get_device_from_local_id(zmk_behavior_local_id_t local_id) {
+    const struct zmk_behavior_local_id_map *item = behavior_find_local_id(local_id);
+
+    return item && z_device_is_ready(item->device) ? item->device : NULL;
+}
+
+zmk_behavior_local_id_t zmk_behavior_get_local_id(const char *name) {
+    if (name == NULL || name[0] == '\0') {
+        return ZMK_BEHAVIOR_LOCAL_ID_NONE;
+    }
+
+    STRUCT_SECTION_FOREACH(zmk_behavior_ref, item) {
+        if (item->device->name == name || strcmp(item->device->name, name) == 0) {
+            return item->local_id;
+        }
+    }
+
+    return ZMK_BEHAVIOR_LOCAL_ID_NONE;
+}
+
+static int behavior_local_id_map_init(void) {
+    // The map has one slot per behavior. Insertion sort is fine for a few dozen entries, once.
+    ptrdiff_t len = 0;
+    STRUCT_SECTION_FOREACH(zmk_behavior_ref, ref) {
+        struct zmk_behavior_local_id_map *slot;
+        ptrdiff_t i = len++;
+
+        for (; i > 0; i--) {
+            struct zmk_behavior_local_id_map *prev;
+            STRUCT_SECTION_GET(zmk_behavior_local_id_map, i - 1, &prev);
+            if (prev->local_id < ref->local_id) {
+                break;
+            }
+
+            STRUCT_SECTION_GET(zmk_behavior_local_id_map, i, &slot);
+            *slot = *prev;
+        }
+
+        STRUCT_SECTION_GET(zmk_behavior_local_id_map, i, &slot);
+        slot->device = ref->device;
+        slot->local_id = ref->local_id;
+    }
+
+    return 0;
+}
+
+SYS_INIT(behavior_local_id_map_init, PRE_KERNEL_1, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+
 #if IS_ENABLED(CONFIG_LOG)
 static int check_behavior_names(void) {
     // Behavior names must be unique, but we don't have a good way to enforce this
@@ -17,13 +17,31 @@
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+/* Fractions of max speed are Q16, so this is full speed. */
+#define FRACTION_ONE BIT(16)
+
+/* The acceleration curve is stored as this many linear segments from zero to max speed. */
+#define CURVE_SEGMENTS 32
+
+/*
+ * Movement is tracked in sub-pixels, so that speed (pixels/s) times fraction times trigger period
+ * (ms) is exact and the remainder carried between ticks never drifts.
+ */
+#define SUBPIXELS_PER_PIXEL ((int64_t)FRACTION_ONE * MSEC_PER_SEC)
+
+enum acceleration_curve {
+    ACCELERATION_CURVE_POWER,
+    ACCELERATION_CURVE_EASE_OUT,
+    ACCELERATION_CURVE_SMOOTHSTEP,
+};
+
 struct vector2d {
-    float x;
-    float y;
+    int32_t x;
+    int32_t y;
 };
 
 struct movement_state_1d {
-    float remainder;
+    int64_t remainder;
     int16_t speed;
     uint64_t start_time;
 };
@@ -38,6 +56,9 @@ struct behavior_input_two_axis_data {
     const struct device *dev;
 
     struct movement_state_2d state;
+
+    /* Fraction of max speed at the end of each curve segment, built from the config at init. */
+    uint32_t curve[CURVE_SEGMENTS + 1];
 };
 
 struct behavior_input_two_axis_config {
@@ -50,20 +71,39 @@ struct behavior_input_two_axis_config {
     // acceleration exponent 1: uniform acceleration
     // acceleration exponent 2: uniform jerk
     uint8_t acceleration_exponent;
+    enum acceleration_curve acceleration_curve;
 };
 
-#if CONFIG_MINIMAL_LIBC
-static float powf(float base, float exponent) {
-    // poor man's power implementation rounds the exponent down to the nearest integer.
-    float power = 1.0f;
-    for (; exponent >= 1.0f; exponent--) {
-        power = power * base;
+static uint32_t fraction_mul(uint32_t a, uint32_t b) { return ((uint64_t)a * b) / FRACTION_ONE; }
+
+static uint32_t fraction_pow(uint32_t base, uint8_t exponent) {
+    uint32_t power = FRACTION_ONE;
+    for (int i = 0; i < exponent; i++) {
+        power = fraction_mul(power, base);
     }
     return power;
 }
-#else
-#include <math.h>
-#endif
+
+static uint32_t curve_point(const struct behavior_input_two_axis_config *config,
+                            uint32_t time_fraction) {
+    switch (config->acceleration_curve) {
+    case ACCELERATION_CURVE_EASE_OUT:
+        return FRACTION_ONE -
+               fraction_pow(FRACTION_ONE - time_fraction, config->acceleration_exponent);
+    case ACCELERATION_CURVE_SMOOTHSTEP:
+        return fraction_mul(fraction_mul(time_fraction, time_fraction),
+                            3 * FRACTION_ONE - 2 * time_fraction);
+    case ACCELERATION_CURVE_POWER:
+    default:
+        return fraction_pow(time_fraction, config->acceleration_exponent);
+    }
+}
+
+static void build_curve(const struct behavior_input_two_axis_config *config, uint32_t *curve) {
+    for (int i = 0; i <= CURVE_SEGMENTS; i++) {
+        curve[i] = curve_point(config, i * FRACTION_ONE / CURVE_SEGMENTS);
+    }
+}
 
 static int64_t ms_since_start(int64_t start, int64_t now, int64_t delay) {
     if (start == 0) {
@@ -77,58 +117,67 @@ static int64_t ms_since_start(int64_t start, int64_t now, int64_t delay) {
     return move_duration;
 }
 
-static float speed(const struct behavior_input_two_axis_config *config, float max_speed,
-                   int64_t duration_ms) {
+static uint32_t speed_fraction(const struct behavior_input_two_axis_config *config,
+                               const uint32_t *curve, int64_t duration_ms) {
     // Calculate the speed based on MouseKeysAccel
     // See https://en.wikipedia.org/wiki/Mouse_keys
     if (duration_ms == 0) {
         return 0;
     }
 
-    if (duration_ms > config->time_to_max_speed_ms || config->time_to_max_speed_ms == 0 ||
+    if (duration_ms >= config->time_to_max_speed_ms || config->time_to_max_speed_ms == 0 ||
         config->acceleration_exponent == 0) {
-        return max_speed;
+        return FRACTION_ONE;
     }
-    float time_fraction = (float)duration_ms / config->time_to_max_speed_ms;
-    return max_speed * powf(time_fraction, config->acceleration_exponent);
+
+    // Interpolate within the curve segment the duration falls in.
+    const uint32_t position = duration_ms * CURVE_SEGMENTS;
+    const uint32_t segment = position / config->time_to_max_speed_ms;
+    const uint32_t offset = position % config->time_to_max_speed_ms;
+
+    return curve[segment] + ((uint64_t)(curve[segment + 1] - curve[segment]) * offset) /
+                                config->time_to_max_speed_ms;
 }
 
-static void track_remainder(float *move, float *remainder) {
-    float new_move = *move + *remainder;
-    *remainder = new_move - (int)new_move;
-    *move = (int)new_move;
+static int32_t track_remainder(int64_t move, int64_t *remainder) {
+    int64_t new_move = move + *remainder;
+    // Division truncates towards zero, so the remainder keeps the sign of the movement.
+    int64_t whole = new_move / SUBPIXELS_PER_PIXEL;
+    *remainder = new_move - whole * SUBPIXELS_PER_PIXEL;
+    return whole;
 }
 
-static float update_movement_1d(const struct behavior_input_two_axis_config *config,
-                                struct movement_state_1d *state, int64_t now) {
-    float move = 0;
+static int32_t update_movement_1d(const struct behavior_input_two_axis_config *config,
+                                  const uint32_t *curve, struct movement_state_1d *state,
+                                  int64_t now) {
     if (state->speed == 0) {
         state->remainder = 0;
-        return move;
+        return 0;
     }
 
     int64_t move_duration = ms_since_start(state->start_time, now, config->delay_ms);
-    move = (move_duration > 0)
-               ? (speed(config, state->speed, move_duration) * config->trigger_period_ms / 1000)
-               : 0;
-
-    track_remainder(&(move), &(state->remainder));
+    int64_t move = 0;
+    if (move_duration > 0) {
+        move = (int64_t)state->speed * speed_fraction(config, curve, move_duration) *
+               config->trigger_period_ms;
+    }
 
-    return move;
+    return track_remainder(move, &state->remainder);
 }
 static struct vector2d update_movement_2d(const struct behavior_input_two_axis_config *config,
-                                          struct movement_state_2d *state, int64_t now) {
+                                          const uint32_t *curve, struct movement_state_2d *state,
+                                          int64_t now) {
     struct vector2d move = {0};
 
     move = (struct vector2d){
-        .x = update_movement_1d(config, &state->x, now),
-        .y = update_movement_1d(config, &state->y, now),
+        .x = update_movement_1d(config, curve, &state->x, now),
+        .y = update_movement_1d(config, curve, &state->y, now),
     };
 
     return move;
 }
 
-static bool is_non_zero_1d_movement(int16_t speed) { return speed != 0; }
+static bool is_non_zero_1d_movement(int32_t speed) { return speed != 0; }
 
 static bool is_non_zero_2d_movement(struct movement_state_2d *state) {
     return is_non_zero_1d_movement(state->x.speed) || is_non_zero_1d_movement(state->y.speed);
@@ -147,10 +196,10 @@ static void tick_work_cb(struct k_work *work) {
 
     uint64_t timestamp = k_uptime_get();
 
-    LOG_INF("x start: %llu, y start: %llu, current timestamp: %llu", data->state.x.start_time,
+    LOG_DBG("x start: %llu, y start: %llu, current timestamp: %llu", data->state.x.start_time,
             data->state.y.start_time, timestamp);
 
-    struct vector2d move = update_movement_2d(cfg, &data->state, timestamp);
+    struct vector2d move = update_movement_2d(cfg, data->curve, &data->state, timestamp);
 
     int ret = 0;
     bool have_x = is_non_zero_1d_movement(move.x);
@@ -210,8 +259,10 @@ int behavior_input_two_axis_adjust_speed(const struct device *dev, int16_t dx, i
 
 static int behavior_input_two_axis_init(const struct device *dev) {
     struct behavior_input_two_axis_data *data = dev->data;
+    const struct behavior_input_two_axis_config *cfg = dev->config;
 
     data->dev = dev;
+    build_curve(cfg, data->curve);
     k_work_init_delayable(&data->tick_work, tick_work_cb);
 
     return 0;
@@ -256,6 +307,7 @@ static const struct behavior_driver_api behavior_input_two_axis_driver_api = {
         .delay_ms = DT_INST_PROP_OR(n, delay_ms, 0),                                               \
         .time_to_max_speed_ms = DT_INST_PROP(n, time_to_max_speed_ms),                             \
         .acceleration_exponent = DT_INST_PROP_OR(n, acceleration_exponent, 1),                     \
+        .acceleration_curve = DT_INST_ENUM_IDX(n, acceleration_curve),                             \
     };                                                                                             \
     BEHAVIOR_DT_INST_DEFINE(                                                                       \
         n, behavior_input_two_axis_init, NULL, &behavior_input_two_axis_data_##n,                  \
@@ -16,9 +16,11 @@ struct behavior_sensor_rotate_config {
     bool override_params;
 };
 
+// Only the highest active layer bound to a sensor receives its data, so the accumulated state
+// only needs to be kept per sensor.
 struct behavior_sensor_rotate_data {
-    struct sensor_value remainder[ZMK_KEYMAP_SENSORS_LEN][ZMK_KEYMAP_LAYERS_LEN];
-    int triggers[ZMK_KEYMAP_SENSORS_LEN][ZMK_KEYMAP_LAYERS_LEN];
+    struct sensor_value remainder[ZMK_KEYMAP_SENSORS_LEN];
+    int triggers[ZMK_KEYMAP_SENSORS_LEN];
 };
 
 int zmk_behavior_sensor_rotate_common_accept_data(
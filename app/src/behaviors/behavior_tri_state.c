@@ -28,7 +28,7 @@ struct behavior_tri_state_config {
     struct zmk_behavior_binding start_behavior;
     struct zmk_behavior_binding continue_behavior;
     struct zmk_behavior_binding end_behavior;
-    int32_t ignored_layers;
+    zmk_keymap_layers_state_t ignored_layers;
     int32_t timeout_ms;
     int tap_ms;
     uint8_t ignored_key_positions[];
@@ -120,11 +120,9 @@ static bool is_other_key_ignored(struct active_tri_state *tri_state, int32_t pos
     return false;
 }
 
-static bool is_layer_ignored(struct active_tri_state *tri_state, int32_t layer) {
-    if ((BIT(layer) & tri_state->config->ignored_layers) != 0U) {
-        return true;
-    }
-    return false;
+static zmk_keymap_layers_state_t unignored_layers(struct active_tri_state *tri_state,
+                                                  zmk_keymap_layers_state_t layers) {
+    return layers & ~tri_state->config->ignored_layers;
 }
 
 static int on_tri_state_binding_pressed(struct zmk_behavior_binding *binding,
@@ -247,7 +245,8 @@ static int tri_state_layer_state_changed_listener(const zmk_event_t *eh) {
     if (ev == NULL) {
         return ZMK_EV_EVENT_BUBBLE;
     }
-    if (!ev->state) {
+    zmk_keymap_layers_state_t activated = ev->changed & ev->layers;
+    if (activated == 0) {
         return ZMK_EV_EVENT_BUBBLE;
     }
     for (int i = 0; i < ZMK_BHV_MAX_ACTIVE_TRI_STATES; i++) {
@@ -255,8 +254,10 @@ static int tri_state_layer_state_changed_listener(const zmk_event_t *eh) {
         if (!tri_state->is_active) {
             continue;
         }
-        if (!is_layer_ignored(tri_state, ev->layer)) {
-            LOG_DBG("Tri-State layer changed, ending at %d %d", tri_state->position, ev->layer);
+        zmk_keymap_layers_state_t unignored = unignored_layers(tri_state, activated);
+        if (unignored != 0) {
+            LOG_DBG("Tri-State layer changed, ending at %d %d", tri_state->position,
+                    zmk_keymap_layers_lowest(unignored));
             tri_state->is_active = false;
             struct zmk_behavior_binding_event event = {.position = tri_state->position,
                                                        .timestamp = k_uptime_get()};
@@ -283,7 +284,7 @@ static int tri_state_layer_state_changed_listener(const zmk_event_t *eh) {
                               (DT_INST_PHA_BY_IDX(node, bindings, idx, param2))),                  \
     }
 
-#define IF_BIT(n, prop, i) BIT(DT_PROP_BY_IDX(n, prop, i)) |
+#define IF_BIT(n, prop, i) ZMK_KEYMAP_LAYER_BIT(DT_PROP_BY_IDX(n, prop, i)) |
 
 #define TRI_STATE_INST(n)                                                                          \
     static struct behavior_tri_state_config behavior_tri_state_config_##n = {                      \
@@ -13,6 +13,7 @@
 #include <stdio.h>
 
 #include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/ring_buffer.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include <zephyr/bluetooth/conn.h>
@@ -105,7 +106,35 @@ static bt_addr_le_t peripheral_addrs[ZMK_SPLIT_BLE_PERIPHERAL_COUNT];
 
 #endif /* IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL) */
 
+/* Connection interval of the active profile in microseconds, or 0 while it isn't connected. Cached
+ * so pacing each mouse report doesn't have to look the connection up. */
+static atomic_t active_profile_interval_us;
+
+static void update_active_profile_interval(void) {
+    struct bt_conn *conn;
+    struct bt_conn_info info;
+    uint32_t interval_us = 0;
+    bt_addr_le_t *addr = zmk_ble_active_profile_addr();
+
+    if (bt_addr_le_cmp(addr, BT_ADDR_LE_ANY) &&
+        (conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr)) != NULL) {
+        bt_conn_get_info(conn, &info);
+        bt_conn_unref(conn);
+
+        if (info.state == BT_CONN_STATE_CONNECTED) {
+            // The connection interval is in units of 1.25 ms.
+            interval_us = info.le.interval * 1250;
+        }
+    }
+
+    atomic_set(&active_profile_interval_us, interval_us);
+}
+
 static void raise_profile_changed_event(void) {
+    // Every change to the active profile's connection, or to which profile is active, comes
+    // through here.
+    update_active_profile_interval();
+
     raise_zmk_ble_active_profile_changed((struct zmk_ble_active_profile_changed){
         .index = active_profile, .profile = &profiles[active_profile]});
 }
@@ -152,6 +181,10 @@ bool zmk_ble_active_profile_is_connected(void) {
     return info.state == BT_CONN_STATE_CONNECTED;
 }
 
+uint32_t zmk_ble_active_profile_interval_us(void) {
+    return (uint32_t)atomic_get(&active_profile_interval_us);
+}
+
 int8_t zmk_ble_profile_status(uint8_t index) {
     if (index >= ZMK_BLE_PROFILE_COUNT)
         return -1;
@@ -504,6 +537,8 @@ static void connected(struct bt_conn *conn, uint8_t err) {
 
     if (is_conn_active_profile(conn)) {
         LOG_DBG("Active profile connected");
+        // The connection interval is in units of 1.25 ms.
+        atomic_set(&active_profile_interval_us, info.le.interval * 1250);
         k_work_submit(&raise_profile_changed_event_work);
     }
 }
@@ -529,6 +564,7 @@ static void disconnected(struct bt_conn *conn, uint8_t reason) {
 
     if (is_conn_active_profile(conn)) {
         LOG_DBG("Active profile disconnected");
+        atomic_set(&active_profile_interval_us, 0);
         k_work_submit(&raise_profile_changed_event_work);
     }
 }
@@ -552,6 +588,11 @@ static void le_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t l
     bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
     LOG_DBG("%s: interval %d latency %d timeout %d", addr, interval, latency, timeout);
+
+    if (is_conn_active_profile(conn)) {
+        // The connection interval is in units of 1.25 ms.
+        atomic_set(&active_profile_interval_us, interval * 1250);
+    }
 }
 
 static struct bt_conn_cb conn_callbacks = {
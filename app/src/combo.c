@@ -38,6 +38,8 @@ struct combo_cfg {
     // the virtual key position is a key position outside the range used by the keyboard.
     // it is necessary so hold-taps can uniquely identify a behavior.
     int32_t virtual_key_position;
+    // the layers this combo is active on, built from layers[] when the combo is initialized.
+    zmk_keymap_layers_state_t layer_mask;
     int32_t layers_len;
     int8_t layers[];
 };
@@ -91,6 +93,20 @@ static void store_last_tapped(int64_t timestamp) {
 // Store the combo key pointer in the combos array, one pointer for each key position
 // The combos are sorted shortest-first, then by virtual-key-position.
 static int initialize_combo(struct combo_cfg *new_combo) {
+    if (new_combo->layers[0] == -1) {
+        // -1 in the first layer position is global layer scope
+        new_combo->layer_mask = ~(zmk_keymap_layers_state_t)0;
+    } else {
+        for (int j = 0; j < new_combo->layers_len; j++) {
+            if (new_combo->layers[j] < 0 || new_combo->layers[j] >= ZMK_KEYMAP_LAYERS_LEN) {
+                LOG_ERR("Unable to initialize combo, layer %d does not exist",
+                        new_combo->layers[j]);
+                return -EINVAL;
+            }
+            new_combo->layer_mask |= ZMK_KEYMAP_LAYER_BIT(new_combo->layers[j]);
+        }
+    }
+
     for (int i = 0; i < new_combo->key_position_len; i++) {
         int32_t position = new_combo->key_positions[i];
         if (position >= ZMK_KEYMAP_LEN) {
@@ -126,16 +142,7 @@ static int initialize_combo(struct combo_cfg *new_combo) {
 }
 
 static bool combo_active_on_layer(struct combo_cfg *combo, uint8_t layer) {
-    if (combo->layers[0] == -1) {
-        // -1 in the first layer position is global layer scope
-        return true;
-    }
-    for (int j = 0; j < combo->layers_len; j++) {
-        if (combo->layers[j] == layer) {
-            return true;
-        }
-    }
-    return false;
+    return (combo->layer_mask & ZMK_KEYMAP_LAYER_BIT(layer)) != 0;
 }
 
 static bool is_quick_tap(struct combo_cfg *combo, int64_t timestamp) {
@@ -12,16 +12,13 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/logging/log.h>
 
-#include <zmk/event_manager.h>
+#include <zmk/conditional_layer.h>
 #include <zmk/keymap.h>
-#include <zmk/events/layer_state_changed.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
 
-static K_SEM_DEFINE(conditional_layer_sem, 1, 1);
-
 // Conditional layer configuration that activates the specified then-layer when all if-layers are
 // active. With two if-layers, this is referred to as "tri-layer", and is commonly used to activate
 // a third "adjust" layer if and only if the "lower" and "raise" layers are both active.
@@ -33,7 +30,8 @@ struct conditional_layer_cfg {
     int8_t then_layer;
 };
 
-#define IF_LAYER_BIT(node_id, prop, idx) BIT(DT_PROP_BY_IDX(node_id, prop, idx)) |
+#define IF_LAYER_BIT(node_id, prop, idx)                                                           \
+    ZMK_KEYMAP_LAYER_BIT(DT_PROP_BY_IDX(node_id, prop, idx)) |
 
 // Evaluates to conditional_layer_cfg struct initializer.
 #define CONDITIONAL_LAYER_DECL(n)                                                                  \
@@ -49,76 +47,76 @@ static const struct conditional_layer_cfg CONDITIONAL_LAYER_CFGS[] = {
 static const int32_t NUM_CONDITIONAL_LAYER_CFGS =
     sizeof(CONDITIONAL_LAYER_CFGS) / sizeof(*CONDITIONAL_LAYER_CFGS);
 
-static void conditional_layer_activate(int8_t layer) {
-    // This may trigger another event that could, in turn, activate additional then-layers. However,
-    // the process will eventually terminate (at worst, when every layer is active).
-    if (!zmk_keymap_layer_active(layer)) {
+static void conditional_layer_activate(zmk_keymap_layers_state_t *state, int8_t layer) {
+    // This may lead to activation of additional then-layers on the next pass. However, the process
+    // will eventually terminate (at worst, when every layer is active).
+    if ((*state & ZMK_KEYMAP_LAYER_BIT(layer)) == 0U) {
         LOG_DBG("layer %d", layer);
-        zmk_keymap_layer_activate(layer);
+        *state |= ZMK_KEYMAP_LAYER_BIT(layer);
     }
 }
 
-static void conditional_layer_deactivate(int8_t layer) {
+static void conditional_layer_deactivate(zmk_keymap_layers_state_t *state, int8_t layer) {
     // This may deactivate a then-layer that's already active via another mechanism (e.g., a
     // momentary layer behavior). However, the same problem arises when multiple keys with the same
     // &mo binding are held and then one is released, so it's probably not an issue in practice.
-    if (zmk_keymap_layer_active(layer)) {
+    if ((*state & ZMK_KEYMAP_LAYER_BIT(layer)) != 0U) {
         LOG_DBG("layer %d", layer);
-        zmk_keymap_layer_deactivate(layer);
+        *state &= ~ZMK_KEYMAP_LAYER_BIT(layer);
     }
 }
 
-static int layer_state_changed_listener(const zmk_event_t *ev) {
-    static bool conditional_layer_updates_needed;
-
-    conditional_layer_updates_needed = true;
+zmk_keymap_layers_state_t zmk_conditional_layer_resolve(zmk_keymap_layers_state_t state) {
+    bool conditional_layer_updates_needed = true;
 
-    // Semaphore ensures we don't re-enter the loop in the middle of doing update, and
-    // ensures that "waterfalling layer updates" are all processed to trigger subsequent
-    // nested conditional layers properly.
-    if (k_sem_take(&conditional_layer_sem, K_NO_WAIT) < 0) {
-        return 0;
-    }
+    // Each pass can only change then-layers, so a well-formed configuration settles in at most one
+    // pass per config. The bound guards against configs that feed back into each other.
+    for (int pass = 0; conditional_layer_updates_needed; pass++) {
+        zmk_keymap_layers_state_t then_layers = 0;
+        zmk_keymap_layers_state_t then_layer_state = 0;
 
-    while (conditional_layer_updates_needed) {
-        int8_t max_then_layer = -1;
-        uint32_t then_layers = 0;
-        uint32_t then_layer_state = 0;
+        if (pass > NUM_CONDITIONAL_LAYER_CFGS) {
+            LOG_WRN("Conditional layers did not settle, keeping the last layer state");
+            break;
+        }
 
         conditional_layer_updates_needed = false;
 
-        // On layer state changes, examines each conditional layer config to determine if then-layer
-        // in the config should activate based on the currently active set of if-layers.
+        // Examines each conditional layer config to determine if then-layer in the config should
+        // activate based on the set of if-layers active at the start of this pass.
         for (int i = 0; i < NUM_CONDITIONAL_LAYER_CFGS; i++) {
             const struct conditional_layer_cfg *cfg = CONDITIONAL_LAYER_CFGS + i;
             zmk_keymap_layers_state_t mask = cfg->if_layers_state_mask;
-            then_layers |= BIT(cfg->then_layer);
-            max_then_layer = MAX(max_then_layer, cfg->then_layer);
-
-            // Activate then-layer if and only if all if-layers are already active. Note that we
-            // reevaluate the current layer state for each config since activation of one layer can
-            // also trigger activation of another.
-            if ((zmk_keymap_layer_state() & mask) == mask) {
-                then_layer_state |= BIT(cfg->then_layer);
+            then_layers |= ZMK_KEYMAP_LAYER_BIT(cfg->then_layer);
+
+            // Activate then-layer if and only if all if-layers are already active.
+            if ((state & mask) == mask) {
+                then_layer_state |= ZMK_KEYMAP_LAYER_BIT(cfg->then_layer);
             }
         }
 
-        for (uint8_t layer = 0; layer <= max_then_layer; layer++) {
-            if ((BIT(layer) & then_layers) != 0U) {
-                if ((BIT(layer) & then_layer_state) != 0U) {
-                    conditional_layer_activate(layer);
-                } else {
-                    conditional_layer_deactivate(layer);
-                }
+        zmk_keymap_layers_state_t prev_state = state;
+
+        int layer;
+        ZMK_KEYMAP_LAYERS_FOREACH(layer, then_layers) {
+            if ((ZMK_KEYMAP_LAYER_BIT(layer) & then_layer_state) != 0U) {
+                conditional_layer_activate(&state, layer);
+            } else {
+                conditional_layer_deactivate(&state, layer);
             }
         }
+
+        // Changing a then-layer may satisfy (or break) another config, so go around again.
+        conditional_layer_updates_needed = (state != prev_state);
     }
 
-    k_sem_give(&conditional_layer_sem);
-    return 0;
+    return state;
 }
 
-ZMK_LISTENER(conditional_layer, layer_state_changed_listener);
-ZMK_SUBSCRIPTION(conditional_layer, zmk_layer_state_changed);
+#else
+
+zmk_keymap_layers_state_t zmk_conditional_layer_resolve(zmk_keymap_layers_state_t state) {
+    return state;
+}
 
 #endif
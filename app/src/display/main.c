@@ -28,11 +28,15 @@ static lv_obj_t *screen;
 
 __attribute__((weak)) lv_obj_t *zmk_display_status_screen() { return NULL; }
 
-void display_tick_cb(struct k_work *work) { lv_task_handler(); }
-
+/* How long to wait after a widget changes, so changes close together are drawn at once. */
 #define TICK_MS 10
 
-K_WORK_DEFINE(display_tick_work, display_tick_cb);
+/* LVGL is only run while the display is unblanked. */
+static bool refresh_enabled;
+
+static void display_tick_cb(struct k_work *work);
+
+K_WORK_DELAYABLE_DEFINE(display_tick_work, display_tick_cb);
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_WORK_QUEUE_DEDICATED)
 
@@ -50,19 +54,80 @@ struct k_work_q *zmk_display_work_q() {
 #endif
 }
 
-void display_timer_cb() { k_work_submit_to_queue(zmk_display_work_q(), &display_tick_work); }
+/* Time until the next LVGL timer other than the display refresh is due, capped at the idle tick. */
+static uint32_t display_idle_tick_ms(void) {
+    lv_disp_t *disp = lv_disp_get_default();
+    uint32_t next_ms = CONFIG_ZMK_DISPLAY_IDLE_TICK_MS;
+
+    for (lv_timer_t *timer = lv_timer_get_next(NULL); timer != NULL;
+         timer = lv_timer_get_next(timer)) {
+        if (timer->paused || (disp != NULL && timer == disp->refr_timer)) {
+            continue;
+        }
+
+        uint32_t elapsed = lv_tick_elaps(timer->last_run);
+        uint32_t remaining = elapsed < timer->period ? timer->period - elapsed : 0;
+
+        next_ms = MIN(next_ms, remaining);
+    }
+
+    return next_ms;
+}
+
+static bool display_refresh_pending(void) {
+    lv_disp_t *disp = lv_disp_get_default();
+
+    // Areas not drawn yet, or a running animation that will invalidate more.
+    return (disp != NULL && disp->inv_p > 0) || lv_anim_count_running() > 0;
+}
+
+static void display_tick_cb(struct k_work *work) {
+    uint32_t next_ms = lv_task_handler();
+
+    if (!refresh_enabled) {
+        return;
+    }
+
+    // Keep running LVGL at its own pace while it has something left to draw. Once the screen is
+    // up to date, wait for the next widget timer instead, or the idle tick, which also picks up
+    // changes made to LVGL objects without calling zmk_display_invalidate().
+    if (display_refresh_pending()) {
+        if (next_ms == LV_NO_TIMER_READY) {
+            next_ms = TICK_MS;
+        }
+    } else {
+        next_ms = display_idle_tick_ms();
+    }
+
+    k_work_schedule_for_queue(zmk_display_work_q(), &display_tick_work, K_MSEC(next_ms));
+}
+
+void zmk_display_invalidate(void) {
+    if (!refresh_enabled) {
+        return;
+    }
 
-K_TIMER_DEFINE(display_timer, display_timer_cb, NULL);
+    // Bring the idle tick forward, but don't push back a run that is already due soon, so that
+    // changes close together are still drawn at once.
+    if (!k_work_delayable_is_pending(&display_tick_work) ||
+        k_work_delayable_remaining_get(&display_tick_work) > k_ms_to_ticks_ceil32(TICK_MS)) {
+        k_work_reschedule_for_queue(zmk_display_work_q(), &display_tick_work, K_MSEC(TICK_MS));
+    }
+}
 
 void unblank_display_cb(struct k_work *work) {
     display_blanking_off(display);
-    k_timer_start(&display_timer, K_MSEC(TICK_MS), K_MSEC(TICK_MS));
+    refresh_enabled = true;
+
+    // Draw whatever changed while the display was blanked.
+    k_work_schedule_for_queue(zmk_display_work_q(), &display_tick_work, K_NO_WAIT);
 }
 
 #if IS_ENABLED(CONFIG_ZMK_DISPLAY_BLANK_ON_IDLE)
 
 void blank_display_cb(struct k_work *work) {
-    k_timer_stop(&display_timer);
+    refresh_enabled = false;
+    k_work_cancel_delayable(&display_tick_work);
     display_blanking_on(display);
 }
 K_WORK_DEFINE(blank_display_work, blank_display_cb);
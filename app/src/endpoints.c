@@ -237,6 +237,26 @@ int zmk_endpoints_send_mouse_report() {
     LOG_ERR("Unhandled endpoint transport %d", current_instance.transport);
     return -ENOTSUP;
 }
+
+uint32_t zmk_endpoints_mouse_report_interval_us(void) {
+    switch (current_instance.transport) {
+    case ZMK_TRANSPORT_USB:
+#if IS_ENABLED(CONFIG_ZMK_USB)
+        return CONFIG_USB_HID_POLL_INTERVAL_MS * USEC_PER_MSEC;
+#else
+        return 0;
+#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
+
+    case ZMK_TRANSPORT_BLE:
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+        return zmk_ble_active_profile_interval_us();
+#else
+        return 0;
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+    }
+
+    return 0;
+}
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
 
 #if IS_ENABLED(CONFIG_SETTINGS)
@@ -21,6 +21,9 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
 #include <zmk/hid_indicators.h>
 #endif // IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+#include <zmk/keymap_update.h>
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
 
 enum {
     HIDS_REMOTE_WAKE = BIT(0),
@@ -78,6 +81,16 @@ static struct hids_report mouse_input = {
 
 #endif // IS_ENABLED(CONFIG_ZMK_MOUSE)
 
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+
+// The keymap update report is in the shared report map, so it needs a matching characteristic.
+static struct hids_report keymap_update_output = {
+    .id = ZMK_HID_REPORT_ID_KEYMAP_UPDATE,
+    .type = HIDS_OUTPUT,
+};
+
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+
 static bool host_requests_notification = false;
 static uint8_t ctrl_point;
 // static uint8_t proto_mode;
@@ -135,6 +148,23 @@ static ssize_t write_hids_leds_report(struct bt_conn *conn, const struct bt_gatt
 
 #endif // IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
 
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+static ssize_t write_hids_keymap_update_report(struct bt_conn *conn,
+                                               const struct bt_gatt_attr *attr, const void *buf,
+                                               uint16_t len, uint16_t offset, uint8_t flags) {
+    if (offset != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    // Unlike the USB report, the report ID isn't part of the value here.
+    if (zmk_keymap_update_submit(buf, len) < 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    return len;
+}
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+
 static ssize_t read_hids_consumer_input_report(struct bt_conn *conn,
                                                const struct bt_gatt_attr *attr, void *buf,
                                                uint16_t len, uint16_t offset) {
@@ -217,6 +247,14 @@ BT_GATT_SERVICE_DEFINE(
                        NULL, &led_indicators),
 #endif // IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
 
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT,
+                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                           BT_GATT_PERM_WRITE_ENCRYPT, NULL, write_hids_keymap_update_report, NULL),
+    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
+                       NULL, &keymap_update_output),
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+
     BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_CTRL_POINT, BT_GATT_CHRC_WRITE_WITHOUT_RESP,
                            BT_GATT_PERM_WRITE, NULL, write_ctrl_point, &ctrl_point));
 
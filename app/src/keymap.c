@@ -4,13 +4,19 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <stdio.h>
+
 #include <drivers/behavior.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/settings/settings.h>
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/behavior.h>
+#include <zmk/conditional_layer.h>
 #include <zmk/keymap.h>
 #include <zmk/matrix.h>
 #include <zmk/sensors.h>
@@ -26,13 +32,54 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/events/layer_state_changed.h>
 #include <zmk/events/sensor_event.h>
 
+BUILD_ASSERT(ZMK_KEYMAP_LAYERS_LEN <= ZMK_KEYMAP_LAYERS_STATE_BITS,
+             "ERROR: The keymap has more layers than the layer state can hold (64 maximum)");
+
 static zmk_keymap_layers_state_t _zmk_keymap_layer_state = 0;
 static uint8_t _zmk_keymap_layer_default = 0;
 
 #define DT_DRV_COMPAT zmk_keymap
 
-#define TRANSFORMED_LAYER(node)                                                                    \
-    { LISTIFY(DT_PROP_LEN(node, bindings), ZMK_KEYMAP_EXTRACT_BINDING, (, ), node) }
+#define KEYMAP_BINDING_PARAM(layer, idx, cell)                                                     \
+    COND_CODE_0(DT_PHA_HAS_CELL_AT_IDX(layer, bindings, idx, cell), (0),                           \
+                (DT_PHA_BY_IDX(layer, bindings, idx, cell)))
+
+// Each param is stored in 16 bits unless some binding in the keymap needs more. These expand to
+// plain integer expressions, so the widths are picked by the preprocessor below.
+#define KEYMAP_BINDING_PARAM_IS_WIDE(idx, layer, cell)                                             \
+    || (KEYMAP_BINDING_PARAM(layer, idx, cell) > 0xFFFF)
+#define KEYMAP_LAYER_PARAM_IS_WIDE(layer, cell)                                                    \
+    LISTIFY(DT_PROP_LEN(layer, bindings), KEYMAP_BINDING_PARAM_IS_WIDE, (), layer, cell)
+
+#if 0 DT_INST_FOREACH_CHILD_VARGS(0, KEYMAP_LAYER_PARAM_IS_WIDE, param1)
+typedef uint32_t keymap_param1_t;
+#else
+typedef uint16_t keymap_param1_t;
+#endif
+
+#if 0 DT_INST_FOREACH_CHILD_VARGS(0, KEYMAP_LAYER_PARAM_IS_WIDE, param2)
+typedef uint32_t keymap_param2_t;
+#else
+typedef uint16_t keymap_param2_t;
+#endif
+
+// The keymap as defined in devicetree, kept in flash. Behaviors are referenced by local ID rather
+// than by name, so an entry is 6 to 10 bytes instead of the 12 of a zmk_behavior_binding.
+struct keymap_packed_binding {
+    keymap_param1_t param1;
+    keymap_param2_t param2;
+    zmk_behavior_local_id_t behavior;
+} __packed;
+
+#define PACKED_BINDING(idx, layer)                                                                 \
+    {                                                                                              \
+        .param1 = KEYMAP_BINDING_PARAM(layer, idx, param1),                                        \
+        .param2 = KEYMAP_BINDING_PARAM(layer, idx, param2),                                        \
+        .behavior = ZMK_BEHAVIOR_LOCAL_ID(DT_PHANDLE_BY_IDX(layer, bindings, idx)),                \
+    }
+
+#define PACKED_LAYER(node)                                                                         \
+    { LISTIFY(DT_PROP_LEN(node, bindings), PACKED_BINDING, (, ), node) }
 
 #if ZMK_KEYMAP_HAS_SENSORS
 #define _TRANSFORM_SENSOR_ENTRY(idx, layer)                                                        \
@@ -59,10 +106,28 @@ static uint8_t _zmk_keymap_layer_default = 0;
 // When a behavior handles a key position "down" event, we record the layer state
 // here so that even if that layer is deactivated before the "up", event, we
 // still send the release event to the behavior in that layer also.
-static uint32_t zmk_keymap_active_behavior_layer[ZMK_KEYMAP_LEN];
+static zmk_keymap_layers_state_t zmk_keymap_active_behavior_layer[ZMK_KEYMAP_LEN];
+
+static const struct keymap_packed_binding zmk_keymap[ZMK_KEYMAP_LAYERS_LEN][ZMK_KEYMAP_LEN] = {
+    DT_INST_FOREACH_CHILD_SEP(0, PACKED_LAYER, (, ))};
+
+// Bindings changed at runtime. Only the positions flagged in zmk_keymap_overridden need to be
+// looked up here, every other position reads straight from zmk_keymap.
+struct keymap_override {
+    uint32_t param1;
+    uint32_t param2;
+    zmk_behavior_local_id_t behavior;
+    uint16_t position;
+    uint8_t layer;
+};
+
+static struct keymap_override zmk_keymap_overrides[CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES];
+static uint8_t zmk_keymap_overrides_len;
+static uint32_t zmk_keymap_overridden[ZMK_KEYMAP_LAYERS_LEN][DIV_ROUND_UP(ZMK_KEYMAP_LEN, 32)];
 
-static struct zmk_behavior_binding zmk_keymap[ZMK_KEYMAP_LAYERS_LEN][ZMK_KEYMAP_LEN] = {
-    DT_INST_FOREACH_CHILD_SEP(0, TRANSFORMED_LAYER, (, ))};
+// Positions currently held. Their bindings can't change until they are released, or the release
+// would go to a different behavior than the press.
+static uint32_t zmk_keymap_pressed[DIV_ROUND_UP(ZMK_KEYMAP_LEN, 32)];
 
 static const char *zmk_keymap_layer_names[ZMK_KEYMAP_LAYERS_LEN] = {
     DT_INST_FOREACH_CHILD_SEP(0, LAYER_NAME, (, ))};
@@ -73,10 +138,48 @@ static struct zmk_behavior_binding
     zmk_sensor_keymap[ZMK_KEYMAP_LAYERS_LEN][ZMK_KEYMAP_SENSORS_LEN] = {
         DT_INST_FOREACH_CHILD_SEP(0, SENSOR_LAYER, (, ))};
 
+// The layers of each sensor that bind a behavior able to accept sensor data, resolved once at
+// boot so an event only has to visit the layers that are both bound and active.
+static zmk_keymap_layers_state_t zmk_sensor_keymap_layers[ZMK_KEYMAP_SENSORS_LEN];
+
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+static int commit_layer_state(zmk_keymap_layers_state_t new_state) {
+    // Default layer should *always* remain active
+    new_state |= _zmk_keymap_layer_state & ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default);
+
+    // Conditional layers are resolved to a fixed point before anything is published, so listeners
+    // only ever observe the final state of the transition.
+    new_state = zmk_conditional_layer_resolve(new_state);
+    new_state |= _zmk_keymap_layer_state & ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default);
+
+    zmk_keymap_layers_state_t old_state = _zmk_keymap_layer_state;
+    zmk_keymap_layers_state_t changed = old_state ^ new_state;
+    // Don't send state changes unless there was an actual change
+    if (changed == 0) {
+        return 0;
+    }
+
+    _zmk_keymap_layer_state = new_state;
+
+    int layer;
+    ZMK_KEYMAP_LAYERS_FOREACH_DESC(layer, changed & ~new_state) {
+        LOG_DBG("layer_changed: layer %d state %d", layer, 0);
+    }
+    ZMK_KEYMAP_LAYERS_FOREACH(layer, changed & new_state) {
+        LOG_DBG("layer_changed: layer %d state %d", layer, 1);
+    }
+
+    int ret = raise_layer_state_changed(old_state, new_state);
+    if (ret < 0) {
+        LOG_WRN("Failed to raise layer state changed (%d)", ret);
+    }
+    zmk_split_bt_update_layers(new_state);
+
+    return ret;
+}
+
 static inline int set_layer_state(uint8_t layer, bool state) {
-    int ret = 0;
     if (layer >= ZMK_KEYMAP_LAYERS_LEN) {
         return -EINVAL;
     }
@@ -86,19 +189,14 @@ static inline int set_layer_state(uint8_t layer, bool state) {
         return 0;
     }
 
-    zmk_keymap_layers_state_t old_state = _zmk_keymap_layer_state;
-    WRITE_BIT(_zmk_keymap_layer_state, layer, state);
-    // Don't send state changes unless there was an actual change
-    if (old_state != _zmk_keymap_layer_state) {
-        LOG_DBG("layer_changed: layer %d state %d", layer, state);
-        ret = raise_layer_state_changed(layer, state);
-        if (ret < 0) {
-            LOG_WRN("Failed to raise layer state changed (%d)", ret);
-        }
-        zmk_split_bt_update_layers(_zmk_keymap_layer_state);
+    zmk_keymap_layers_state_t new_state = _zmk_keymap_layer_state;
+    if (state) {
+        new_state |= ZMK_KEYMAP_LAYER_BIT(layer);
+    } else {
+        new_state &= ~ZMK_KEYMAP_LAYER_BIT(layer);
     }
 
-    return ret;
+    return commit_layer_state(new_state);
 }
 
 uint8_t zmk_keymap_layer_default(void) { return _zmk_keymap_layer_default; }
@@ -108,7 +206,7 @@ zmk_keymap_layers_state_t zmk_keymap_layer_state(void) { return _zmk_keymap_laye
 bool zmk_keymap_layer_active_with_state(uint8_t layer, zmk_keymap_layers_state_t state_to_test) {
     // The default layer is assumed to be ALWAYS ACTIVE so we include an || here to ensure nobody
     // breaks up that assumption by accident
-    return (state_to_test & (BIT(layer))) == (BIT(layer)) || layer == _zmk_keymap_layer_default;
+    return (state_to_test & ZMK_KEYMAP_LAYER_BIT(layer)) != 0 || layer == _zmk_keymap_layer_default;
 };
 
 bool zmk_keymap_layer_active(uint8_t layer) {
@@ -116,12 +214,8 @@ bool zmk_keymap_layer_active(uint8_t layer) {
 };
 
 uint8_t zmk_keymap_highest_layer_active(void) {
-    for (uint8_t layer = ZMK_KEYMAP_LAYERS_LEN - 1; layer > 0; layer--) {
-        if (zmk_keymap_layer_active(layer)) {
-            return layer;
-        }
-    }
-    return zmk_keymap_layer_default();
+    return zmk_keymap_layers_highest(_zmk_keymap_layer_state |
+                                     ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default));
 }
 
 int zmk_keymap_layer_activate(uint8_t layer) { return set_layer_state(layer, true); };
@@ -137,17 +231,23 @@ int zmk_keymap_layer_toggle(uint8_t layer) {
 };
 
 int zmk_keymap_layer_to(uint8_t layer) {
-    for (int i = ZMK_KEYMAP_LAYERS_LEN - 1; i >= 0; i--) {
-        zmk_keymap_layer_deactivate(i);
+    if (layer >= ZMK_KEYMAP_LAYERS_LEN) {
+        return -EINVAL;
     }
 
-    zmk_keymap_layer_activate(layer);
+    return commit_layer_state(ZMK_KEYMAP_LAYER_BIT(layer));
+}
 
-    return 0;
+int zmk_keymap_layer_state_set(zmk_keymap_layers_state_t state) {
+    if (((state >> (ZMK_KEYMAP_LAYERS_LEN - 1)) >> 1) != 0) {
+        return -EINVAL;
+    }
+
+    return commit_layer_state(state);
 }
 
 bool is_active_layer(uint8_t layer, zmk_keymap_layers_state_t layer_state) {
-    return (layer_state & BIT(layer)) == BIT(layer) || layer == _zmk_keymap_layer_default;
+    return (layer_state & ZMK_KEYMAP_LAYER_BIT(layer)) != 0 || layer == _zmk_keymap_layer_default;
 }
 
 const char *zmk_keymap_layer_name(uint8_t layer) {
@@ -158,6 +258,137 @@ const char *zmk_keymap_layer_name(uint8_t layer) {
     return zmk_keymap_layer_names[layer];
 }
 
+static bool keymap_is_overridden(uint8_t layer, uint32_t position) {
+    return (zmk_keymap_overridden[layer][position / 32] & BIT(position % 32)) != 0;
+}
+
+static bool keymap_is_pressed(uint32_t position) {
+    return (zmk_keymap_pressed[position / 32] & BIT(position % 32)) != 0;
+}
+
+static struct keymap_override *keymap_find_override(uint8_t layer, uint32_t position) {
+    for (int i = 0; i < zmk_keymap_overrides_len; i++) {
+        struct keymap_override *override = &zmk_keymap_overrides[i];
+
+        if (override->layer == layer && override->position == position) {
+            return override;
+        }
+    }
+
+    return NULL;
+}
+
+// Reads the params of a binding and returns its behavior, which is only resolved to a name or a
+// device when the caller needs one.
+static zmk_behavior_local_id_t keymap_load_binding(uint8_t layer, uint32_t position,
+                                                   struct zmk_behavior_binding *binding) {
+    if (keymap_is_overridden(layer, position)) {
+        const struct keymap_override *override = keymap_find_override(layer, position);
+
+        binding->param1 = override->param1;
+        binding->param2 = override->param2;
+        return override->behavior;
+    }
+
+    const struct keymap_packed_binding *packed = &zmk_keymap[layer][position];
+
+    binding->param1 = packed->param1;
+    binding->param2 = packed->param2;
+    return packed->behavior;
+}
+
+int zmk_keymap_get_binding(uint8_t layer, uint32_t position, struct zmk_behavior_binding *binding) {
+    if (layer >= ZMK_KEYMAP_LAYERS_LEN || position >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
+    }
+
+    zmk_behavior_local_id_t behavior = keymap_load_binding(layer, position, binding);
+    binding->behavior_dev = (char *)zmk_behavior_find_behavior_name_from_local_id(behavior);
+
+    return 0;
+}
+
+// Checks a change to a key position before anything is changed, except for whether there is room
+// for it in the override table, which depends on the other changes made with it.
+static int keymap_resolve_override(uint8_t layer, uint32_t position,
+                                   const struct zmk_behavior_binding *binding,
+                                   struct keymap_override *change) {
+    if (layer >= ZMK_KEYMAP_LAYERS_LEN || position >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
+    }
+
+    zmk_behavior_local_id_t behavior = zmk_behavior_get_local_id(binding->behavior_dev);
+    if (behavior == ZMK_BEHAVIOR_LOCAL_ID_NONE) {
+        return -ENODEV;
+    }
+
+    if (keymap_is_pressed(position)) {
+        LOG_WRN("Not changing binding at %d on layer %d while it is held", position, layer);
+        return -EBUSY;
+    }
+
+    *change = (struct keymap_override){
+        .param1 = binding->param1,
+        .param2 = binding->param2,
+        .behavior = behavior,
+        .position = position,
+        .layer = layer,
+    };
+
+    return 0;
+}
+
+static bool keymap_override_is_default(const struct keymap_override *change) {
+    const struct keymap_packed_binding *packed = &zmk_keymap[change->layer][change->position];
+
+    return packed->behavior == change->behavior && packed->param1 == change->param1 &&
+           packed->param2 == change->param2;
+}
+
+static int keymap_apply_override(const struct keymap_override *change) {
+    const uint8_t layer = change->layer;
+    const uint16_t position = change->position;
+    struct keymap_override *override =
+        keymap_is_overridden(layer, position) ? keymap_find_override(layer, position) : NULL;
+
+    // Setting a position back to its devicetree binding frees up its override slot.
+    if (keymap_override_is_default(change)) {
+        if (override != NULL) {
+            *override = zmk_keymap_overrides[--zmk_keymap_overrides_len];
+            zmk_keymap_overridden[layer][position / 32] &= ~BIT(position % 32);
+        }
+        return 0;
+    }
+
+    if (override == NULL) {
+        if (zmk_keymap_overrides_len >= ARRAY_SIZE(zmk_keymap_overrides)) {
+            LOG_ERR("No room to change binding at %d on layer %d, all %d overrides are in use. "
+                    "Raise CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES.",
+                    position, layer, CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES);
+            return -ENOMEM;
+        }
+
+        override = &zmk_keymap_overrides[zmk_keymap_overrides_len++];
+        zmk_keymap_overridden[layer][position / 32] |= BIT(position % 32);
+    }
+
+    *override = *change;
+
+    return 0;
+}
+
+int zmk_keymap_set_binding(uint8_t layer, uint32_t position,
+                           const struct zmk_behavior_binding *binding) {
+    struct keymap_override change;
+
+    int err = keymap_resolve_override(layer, position, binding, &change);
+    if (err) {
+        return err;
+    }
+
+    return keymap_apply_override(&change);
+}
+
 int invoke_locally(struct zmk_behavior_binding *binding, struct zmk_behavior_binding_event event,
                    bool pressed) {
     if (pressed) {
@@ -171,7 +402,7 @@ int zmk_keymap_apply_position_state(uint8_t source, int layer, uint32_t position
                                     int64_t timestamp) {
     // We want to make a copy of this, since it may be converted from
     // relative to absolute before being invoked
-    struct zmk_behavior_binding binding = zmk_keymap[layer][position];
+    struct zmk_behavior_binding binding;
     const struct device *behavior;
     struct zmk_behavior_binding_event event = {
         .layer = layer,
@@ -179,15 +410,23 @@ int zmk_keymap_apply_position_state(uint8_t source, int layer, uint32_t position
         .timestamp = timestamp,
     };
 
-    LOG_DBG("layer: %d position: %d, binding name: %s", layer, position, binding.behavior_dev);
+    if (layer >= ZMK_KEYMAP_LAYERS_LEN || position >= ZMK_KEYMAP_LEN) {
+        return -EINVAL;
+    }
 
-    behavior = zmk_behavior_get_binding(binding.behavior_dev);
+    // Resolved straight to the device, as looking the behavior up by name would scan them all.
+    zmk_behavior_local_id_t local_id = keymap_load_binding(layer, position, &binding);
+    behavior = zmk_behavior_get_device_from_local_id(local_id);
 
     if (!behavior) {
         LOG_WRN("No behavior assigned to %d on layer %d", position, layer);
         return 1;
     }
 
+    binding.behavior_dev = (char *)behavior->name;
+
+    LOG_DBG("layer: %d position: %d, binding name: %s", layer, position, binding.behavior_dev);
+
     int err = behavior_keymap_binding_convert_central_state_dependent_params(&binding, event);
     if (err) {
         LOG_ERR("Failed to convert relative to absolute behavior binding (err %d)", err);
@@ -230,19 +469,26 @@ int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pr
                                       int64_t timestamp) {
     if (pressed) {
         zmk_keymap_active_behavior_layer[position] = _zmk_keymap_layer_state;
+        zmk_keymap_pressed[position / 32] |= BIT(position % 32);
+    } else {
+        zmk_keymap_pressed[position / 32] &= ~BIT(position % 32);
     }
-    for (int layer = ZMK_KEYMAP_LAYERS_LEN - 1; layer >= _zmk_keymap_layer_default; layer--) {
-        if (zmk_keymap_layer_active_with_state(layer, zmk_keymap_active_behavior_layer[position])) {
-            int ret = zmk_keymap_apply_position_state(source, layer, position, pressed, timestamp);
-            if (ret > 0) {
-                LOG_DBG("behavior processing to continue to next layer");
-                continue;
-            } else if (ret < 0) {
-                LOG_DBG("Behavior returned error: %d", ret);
-                return ret;
-            } else {
-                return ret;
-            }
+    // Only the active layers at or above the default layer are visited, highest first.
+    zmk_keymap_layers_state_t layers =
+        (zmk_keymap_active_behavior_layer[position] |
+         ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default)) &
+        ~(ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default) - 1);
+    int layer;
+    ZMK_KEYMAP_LAYERS_FOREACH_DESC(layer, layers) {
+        int ret = zmk_keymap_apply_position_state(source, layer, position, pressed, timestamp);
+        if (ret > 0) {
+            LOG_DBG("behavior processing to continue to next layer");
+            continue;
+        } else if (ret < 0) {
+            LOG_DBG("Behavior returned error: %d", ret);
+            return ret;
+        } else {
+            return ret;
         }
     }
 
@@ -253,20 +499,20 @@ int zmk_keymap_position_state_changed(uint8_t source, uint32_t position, bool pr
 int zmk_keymap_sensor_event(uint8_t sensor_index,
                             const struct zmk_sensor_channel_data *channel_data,
                             size_t channel_data_size, int64_t timestamp) {
-    bool opaque_response = false;
-
-    for (int layer = ZMK_KEYMAP_LAYERS_LEN - 1; layer >= 0; layer--) {
+    zmk_keymap_layers_state_t layers =
+        (_zmk_keymap_layer_state | ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default)) &
+        ~(ZMK_KEYMAP_LAYER_BIT(_zmk_keymap_layer_default) - 1) &
+        zmk_sensor_keymap_layers[sensor_index];
+    int layer;
+
+    // The first layer to accept the data owns the event; its behavior keeps the accumulated
+    // remainder for the sensor, so lower layers must not see the same delta again.
+    ZMK_KEYMAP_LAYERS_FOREACH_DESC(layer, layers) {
         struct zmk_behavior_binding *binding = &zmk_sensor_keymap[layer][sensor_index];
 
         LOG_DBG("layer: %d sensor_index: %d, binding name: %s", layer, sensor_index,
                 binding->behavior_dev);
 
-        const struct device *behavior = zmk_behavior_get_binding(binding->behavior_dev);
-        if (!behavior) {
-            LOG_DBG("No behavior assigned to %d on layer %d", sensor_index, layer);
-            continue;
-        }
-
         struct zmk_behavior_binding_event event = {
             .layer = layer,
             .position = ZMK_VIRTUAL_KEY_POSITION_SENSOR(sensor_index),
@@ -284,28 +530,352 @@ int zmk_keymap_sensor_event(uint8_t sensor_index,
             continue;
         }
 
-        enum behavior_sensor_binding_process_mode mode =
-            (!opaque_response && layer >= _zmk_keymap_layer_default &&
-             zmk_keymap_layer_active(layer))
-                ? BEHAVIOR_SENSOR_BINDING_PROCESS_MODE_TRIGGER
-                : BEHAVIOR_SENSOR_BINDING_PROCESS_MODE_DISCARD;
-
-        ret = behavior_sensor_keymap_binding_process(binding, event, mode);
-
-        if (ret == ZMK_BEHAVIOR_OPAQUE) {
-            LOG_DBG("sensor event processing complete, behavior response was opaque");
-            opaque_response = true;
-        } else if (ret < 0) {
+        ret = behavior_sensor_keymap_binding_process(binding, event,
+                                                     BEHAVIOR_SENSOR_BINDING_PROCESS_MODE_TRIGGER);
+        if (ret < 0) {
             LOG_DBG("Behavior returned error: %d", ret);
             return ret;
         }
+
+        return 0;
     }
 
     return 0;
 }
 
+static void keymap_sensors_init(void) {
+    for (int sensor_index = 0; sensor_index < ZMK_KEYMAP_SENSORS_LEN; sensor_index++) {
+        for (int layer = 0; layer < ZMK_KEYMAP_LAYERS_LEN; layer++) {
+            const struct device *behavior =
+                zmk_behavior_get_binding(zmk_sensor_keymap[layer][sensor_index].behavior_dev);
+            if (!behavior) {
+                continue;
+            }
+
+            const struct behavior_driver_api *api = behavior->api;
+            if (api->sensor_binding_accept_data == NULL) {
+                LOG_DBG("Behavior %s on layer %d does not accept sensor data", behavior->name,
+                        layer);
+                continue;
+            }
+
+            zmk_sensor_keymap_layers[sensor_index] |= ZMK_KEYMAP_LAYER_BIT(layer);
+        }
+    }
+}
+
 #endif /* ZMK_KEYMAP_HAS_SENSORS */
 
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE)
+
+// layer, position, param1, param2 and the length of the behavior name that follows
+#define KEYMAP_UPDATE_ENTRY_HEADER_LEN 11
+#define KEYMAP_UPDATE_NAME_MAX_LEN 32
+#define KEYMAP_UPDATE_ENTRY_MAX_LEN (KEYMAP_UPDATE_ENTRY_HEADER_LEN + KEYMAP_UPDATE_NAME_MAX_LEN)
+
+BUILD_ASSERT(ZMK_KEYMAP_LEN <= UINT8_MAX + 1, "Key positions must fit in one byte for updates");
+
+static int keymap_update_decode_entry(const uint8_t *data, size_t len,
+                                      struct keymap_override *change, size_t *entry_len) {
+    if (len < KEYMAP_UPDATE_ENTRY_HEADER_LEN) {
+        return -EINVAL;
+    }
+
+    uint8_t name_len = data[10];
+    if (name_len >= KEYMAP_UPDATE_NAME_MAX_LEN || len < KEYMAP_UPDATE_ENTRY_HEADER_LEN + name_len) {
+        return -EINVAL;
+    }
+
+    char name[KEYMAP_UPDATE_NAME_MAX_LEN];
+    memcpy(name, &data[KEYMAP_UPDATE_ENTRY_HEADER_LEN], name_len);
+    name[name_len] = '\0';
+
+    struct zmk_behavior_binding binding = {
+        .behavior_dev = name,
+        .param1 = sys_get_le32(&data[2]),
+        .param2 = sys_get_le32(&data[6]),
+    };
+
+    *entry_len = KEYMAP_UPDATE_ENTRY_HEADER_LEN + name_len;
+
+    return keymap_resolve_override(data[0], data[1], &binding, change);
+}
+
+static size_t keymap_update_encode_override(const struct keymap_override *override,
+                                            uint8_t *data) {
+    const char *name = zmk_behavior_find_behavior_name_from_local_id(override->behavior);
+    uint8_t name_len = MIN(strlen(name), KEYMAP_UPDATE_NAME_MAX_LEN - 1);
+
+    data[0] = override->layer;
+    data[1] = override->position;
+    sys_put_le32(override->param1, &data[2]);
+    sys_put_le32(override->param2, &data[6]);
+    data[10] = name_len;
+    memcpy(&data[KEYMAP_UPDATE_ENTRY_HEADER_LEN], name, name_len);
+
+    return KEYMAP_UPDATE_ENTRY_HEADER_LEN + name_len;
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+// Positions changed since the overrides were last saved. Each override is saved under its own key,
+// so only these have to be written or deleted.
+static uint32_t zmk_keymap_unsaved[ZMK_KEYMAP_LAYERS_LEN][DIV_ROUND_UP(ZMK_KEYMAP_LEN, 32)];
+#endif
+
+static void keymap_mark_unsaved(uint8_t layer, uint32_t position) {
+#if IS_ENABLED(CONFIG_SETTINGS)
+    zmk_keymap_unsaved[layer][position / 32] |= BIT(position % 32);
+#endif
+}
+
+static int keymap_update_clear_overrides(void) {
+    for (int i = 0; i < zmk_keymap_overrides_len; i++) {
+        if (keymap_is_pressed(zmk_keymap_overrides[i].position)) {
+            return -EBUSY;
+        }
+    }
+
+    for (int i = 0; i < zmk_keymap_overrides_len; i++) {
+        keymap_mark_unsaved(zmk_keymap_overrides[i].layer, zmk_keymap_overrides[i].position);
+    }
+
+    zmk_keymap_overrides_len = 0;
+    memset(zmk_keymap_overridden, 0, sizeof(zmk_keymap_overridden));
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+// Each override is saved as "keymap/<layer>/<position>", holding one entry in the encoding the
+// update protocol uses. Nothing needs a buffer for the whole table, and a change rewrites only the
+// positions it touched.
+static int keymap_loaded_overrides;
+
+static int keymap_settings_set(const char *name, size_t len, settings_read_cb read_cb,
+                               void *cb_arg) {
+    uint8_t buf[KEYMAP_UPDATE_ENTRY_MAX_LEN];
+    struct keymap_override change;
+    size_t entry_len;
+
+    if (len > sizeof(buf)) {
+        return -EINVAL;
+    }
+
+    int rc = read_cb(cb_arg, buf, len);
+    if (rc < 0) {
+        return rc;
+    }
+
+    rc = keymap_update_decode_entry(buf, len, &change, &entry_len);
+    if (rc == 0 && entry_len != len) {
+        rc = -EINVAL;
+    }
+    if (rc == 0) {
+        rc = keymap_apply_override(&change);
+    }
+    if (rc < 0) {
+        LOG_WRN("Failed to restore keymap override %s (%d)", name, rc);
+        return rc;
+    }
+
+    keymap_loaded_overrides++;
+
+    return 0;
+}
+
+static int keymap_settings_commit(void) {
+    if (keymap_loaded_overrides > 0) {
+        LOG_DBG("Loaded %d saved keymap overrides", keymap_loaded_overrides);
+        keymap_loaded_overrides = 0;
+    }
+
+    return 0;
+}
+
+struct settings_handler keymap_handler = {
+    .name = "keymap", .h_set = keymap_settings_set, .h_commit = keymap_settings_commit};
+
+static void keymap_save_override(uint8_t layer, uint32_t position) {
+    char name[sizeof("keymap/255/255")];
+    int err;
+
+    snprintf(name, sizeof(name), "keymap/%d/%d", layer, position);
+
+    if (keymap_is_overridden(layer, position)) {
+        uint8_t buf[KEYMAP_UPDATE_ENTRY_MAX_LEN];
+        size_t len = keymap_update_encode_override(keymap_find_override(layer, position), buf);
+
+        err = settings_save_one(name, buf, len);
+    } else {
+        err = settings_delete(name);
+    }
+
+    if (err) {
+        LOG_ERR("Failed to save keymap override %s (err %d)", name, err);
+    }
+}
+
+static void keymap_save_overrides_work(struct k_work *work) {
+    for (int layer = 0; layer < ZMK_KEYMAP_LAYERS_LEN; layer++) {
+        for (int i = 0; i < ARRAY_SIZE(zmk_keymap_unsaved[layer]); i++) {
+            uint32_t unsaved = zmk_keymap_unsaved[layer][i];
+
+            zmk_keymap_unsaved[layer][i] = 0;
+            while (unsaved != 0) {
+                const int bit = find_lsb_set(unsaved) - 1;
+
+                unsaved &= unsaved - 1;
+                keymap_save_override(layer, i * 32 + bit);
+            }
+        }
+    }
+}
+
+static struct k_work_delayable keymap_save_work;
+
+#endif // IS_ENABLED(CONFIG_SETTINGS)
+
+static int keymap_save_overrides(void) {
+#if IS_ENABLED(CONFIG_SETTINGS)
+    int ret = k_work_reschedule(&keymap_save_work, K_MSEC(CONFIG_ZMK_SETTINGS_SAVE_DEBOUNCE));
+    return MIN(ret, 0);
+#else
+    return 0;
+#endif
+}
+
+static int keymap_update_check_set(const uint8_t *data, size_t len, uint8_t count) {
+    uint32_t seen[ZMK_KEYMAP_LAYERS_LEN][DIV_ROUND_UP(ZMK_KEYMAP_LEN, 32)] = {0};
+    int overrides_len = zmk_keymap_overrides_len;
+    size_t offset = 0;
+
+    for (int i = 0; i < count; i++) {
+        struct keymap_override change;
+        size_t entry_len;
+
+        int err = keymap_update_decode_entry(&data[offset], len - offset, &change, &entry_len);
+        // A position may only be changed once per update, so the order entries are applied in
+        // doesn't matter.
+        if (err == 0 && (seen[change.layer][change.position / 32] & BIT(change.position % 32))) {
+            err = -EINVAL;
+        }
+        if (err) {
+            LOG_WRN("Keymap update entry %d failed (%d)", i, err);
+            return err;
+        }
+
+        seen[change.layer][change.position / 32] |= BIT(change.position % 32);
+
+        const bool overridden = keymap_is_overridden(change.layer, change.position);
+        if (keymap_override_is_default(&change)) {
+            overrides_len -= overridden ? 1 : 0;
+        } else {
+            overrides_len += overridden ? 0 : 1;
+        }
+
+        offset += entry_len;
+    }
+
+    if (overrides_len > CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES) {
+        LOG_ERR("No room for keymap update, it needs %d of %d overrides. "
+                "Raise CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES.",
+                overrides_len, CONFIG_ZMK_KEYMAP_RUNTIME_OVERRIDES);
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+// Only called once keymap_update_check_set() has passed, so no entry can fail.
+static void keymap_update_apply_set(const uint8_t *data, size_t len, uint8_t count) {
+    // Entries that restore a devicetree binding go first, freeing their slots for the others.
+    for (int restores = 1; restores >= 0; restores--) {
+        size_t offset = 0;
+
+        for (int i = 0; i < count; i++) {
+            struct keymap_override change;
+            size_t entry_len;
+
+            keymap_update_decode_entry(&data[offset], len - offset, &change, &entry_len);
+            if (keymap_override_is_default(&change) == restores) {
+                keymap_apply_override(&change);
+                keymap_mark_unsaved(change.layer, change.position);
+            }
+
+            offset += entry_len;
+        }
+    }
+}
+
+int zmk_keymap_update(const uint8_t *data, size_t len) {
+    if (len < 1) {
+        return -EINVAL;
+    }
+
+    switch (data[0]) {
+    case ZMK_KEYMAP_UPDATE_OP_SET: {
+        if (len < 2) {
+            return -EINVAL;
+        }
+
+        uint8_t count = data[1];
+
+        // Every entry is checked before any is applied, so a rejected update leaves the keymap
+        // exactly as the host last saw it.
+        int err = keymap_update_check_set(&data[2], len - 2, count);
+        if (err) {
+            return err;
+        }
+
+        keymap_update_apply_set(&data[2], len - 2, count);
+
+        LOG_DBG("Applied %d keymap update entries", count);
+        break;
+    }
+    case ZMK_KEYMAP_UPDATE_OP_RESET: {
+        int err = keymap_update_clear_overrides();
+        if (err) {
+            LOG_WRN("Not resetting the keymap while a changed position is held");
+            return err;
+        }
+
+        LOG_DBG("Reset keymap to its devicetree bindings");
+        break;
+    }
+    default:
+        return -ENOTSUP;
+    }
+
+    return keymap_save_overrides();
+}
+
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE)
+
+static int zmk_keymap_init(void) {
+#if ZMK_KEYMAP_HAS_SENSORS
+    keymap_sensors_init();
+#endif /* ZMK_KEYMAP_HAS_SENSORS */
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE) && IS_ENABLED(CONFIG_SETTINGS)
+    settings_subsys_init();
+
+    int err = settings_register(&keymap_handler);
+    if (err) {
+        LOG_ERR("Failed to register the keymap settings handler (err %d)", err);
+        return err;
+    }
+
+    k_work_init_delayable(&keymap_save_work, keymap_save_overrides_work);
+
+    settings_load_subtree("keymap");
+#endif
+
+    return 0;
+}
+
+SYS_INIT(zmk_keymap_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
 int keymap_listener(const zmk_event_t *eh) {
     const struct zmk_position_state_changed *pos_ev;
     if ((pos_ev = as_zmk_position_state_changed(eh)) != NULL) {
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_BLE)
+#include <zephyr/bluetooth/gatt.h>
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_BLE)
+
+#include <zmk/keymap.h>
+#include <zmk/keymap_update.h>
+
+struct keymap_update_msg {
+    uint8_t len;
+    uint8_t data[ZMK_KEYMAP_UPDATE_MAX_LEN];
+};
+
+K_MSGQ_DEFINE(keymap_update_msgq, sizeof(struct keymap_update_msg), 4, 4);
+
+static void keymap_update_work_callback(struct k_work *work) {
+    struct keymap_update_msg msg;
+
+    while (k_msgq_get(&keymap_update_msgq, &msg, K_NO_WAIT) == 0) {
+        int err = zmk_keymap_update(msg.data, msg.len);
+        if (err) {
+            LOG_WRN("Failed to apply keymap update (err %d)", err);
+        }
+    }
+}
+
+static K_WORK_DEFINE(keymap_update_work, keymap_update_work_callback);
+
+int zmk_keymap_update_submit(const uint8_t *data, size_t len) {
+    if (len == 0 || len > ZMK_KEYMAP_UPDATE_MAX_LEN) {
+        return -EINVAL;
+    }
+
+    struct keymap_update_msg msg = {.len = len};
+    memcpy(msg.data, data, len);
+
+    int err = k_msgq_put(&keymap_update_msgq, &msg, K_NO_WAIT);
+    if (err) {
+        LOG_WRN("Keymap update queue full, dropping message");
+        return -ENOMEM;
+    }
+
+    k_work_submit(&keymap_update_work);
+
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_BLE)
+
+static ssize_t keymap_update_svc_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                       const void *buf, uint16_t len, uint16_t offset,
+                                       uint8_t flags) {
+    if (offset != 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+    }
+
+    if (zmk_keymap_update_submit(buf, len) < 0) {
+        return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+    }
+
+    return len;
+}
+
+BT_GATT_SERVICE_DEFINE(
+    keymap_update_svc,
+    BT_GATT_PRIMARY_SERVICE(BT_UUID_DECLARE_128(ZMK_KEYMAP_UPDATE_BT_SERVICE_UUID)),
+    BT_GATT_CHARACTERISTIC(BT_UUID_DECLARE_128(ZMK_KEYMAP_UPDATE_BT_CHAR_UPDATE_UUID),
+                           BT_GATT_CHRC_WRITE | BT_GATT_CHRC_WRITE_WITHOUT_RESP,
+                           BT_GATT_PERM_WRITE_ENCRYPT, NULL, keymap_update_svc_write, NULL));
+
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_BLE)
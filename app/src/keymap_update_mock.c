@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_keymap_update_mock
+
+#include <string.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/util.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#include <zmk/keymap_update.h>
+
+struct keymap_update_mock_msg {
+    const uint8_t *data;
+    uint8_t len;
+    bool reload_settings;
+    uint32_t delay_ms;
+};
+
+#define MOCK_MSG_DATA(node)                                                                        \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, data),                                                      \
+                (static const uint8_t _CONCAT(keymap_update_mock_data_, DT_DEP_ORD(node))[] =      \
+                     DT_PROP(node, data);),                                                        \
+                ())
+
+#define MOCK_MSG(node)                                                                             \
+    {                                                                                              \
+        .data = COND_CODE_1(DT_NODE_HAS_PROP(node, data),                                          \
+                            (_CONCAT(keymap_update_mock_data_, DT_DEP_ORD(node))), (NULL)),        \
+        .len = DT_PROP_LEN_OR(node, data, 0),                                                      \
+        .reload_settings = DT_PROP(node, reload_settings),                                         \
+        .delay_ms = DT_PROP(node, delay_ms),                                                       \
+    },
+
+DT_INST_FOREACH_CHILD(0, MOCK_MSG_DATA)
+
+static const struct keymap_update_mock_msg keymap_update_mock_msgs[] = {
+    DT_INST_FOREACH_CHILD(0, MOCK_MSG)};
+
+static int keymap_update_mock_index;
+
+static void keymap_update_mock_work_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(keymap_update_mock_work, keymap_update_mock_work_handler);
+
+static void keymap_update_mock_schedule_next(void) {
+    if (keymap_update_mock_index < ARRAY_SIZE(keymap_update_mock_msgs)) {
+        k_work_schedule(&keymap_update_mock_work,
+                        K_MSEC(keymap_update_mock_msgs[keymap_update_mock_index].delay_ms));
+    }
+}
+
+static void keymap_update_mock_work_handler(struct k_work *work) {
+    const struct keymap_update_mock_msg *msg = &keymap_update_mock_msgs[keymap_update_mock_index];
+
+    if (msg->reload_settings) {
+#if IS_ENABLED(CONFIG_SETTINGS)
+        LOG_DBG("Reloading saved keymap overrides");
+        settings_load_subtree("keymap");
+#endif
+    } else {
+        int err = zmk_keymap_update_submit(msg->data, msg->len);
+        if (err) {
+            LOG_WRN("Keymap update message %d rejected (%d)", keymap_update_mock_index, err);
+        }
+    }
+
+    keymap_update_mock_index++;
+    keymap_update_mock_schedule_next();
+}
+
+#if IS_ENABLED(CONFIG_SETTINGS_CUSTOM)
+
+// A settings backend kept in RAM, so that overrides saved during a test can be loaded back
+// without a flash image that would outlive the run.
+
+#define MOCK_SETTINGS_ENTRIES 4
+#define MOCK_SETTINGS_NAME_LEN 32
+#define MOCK_SETTINGS_VALUE_LEN 256
+
+struct mock_settings_entry {
+    char name[MOCK_SETTINGS_NAME_LEN];
+    uint8_t value[MOCK_SETTINGS_VALUE_LEN];
+    size_t len;
+};
+
+static struct mock_settings_entry mock_settings_entries[MOCK_SETTINGS_ENTRIES];
+
+static ssize_t mock_settings_read(void *cb_arg, void *data, size_t len) {
+    const struct mock_settings_entry *entry = cb_arg;
+
+    len = MIN(len, entry->len);
+    memcpy(data, entry->value, len);
+
+    return len;
+}
+
+static int mock_settings_load(struct settings_store *cs, const struct settings_load_arg *arg) {
+    for (int i = 0; i < ARRAY_SIZE(mock_settings_entries); i++) {
+        struct mock_settings_entry *entry = &mock_settings_entries[i];
+
+        if (entry->name[0] != '\0') {
+            settings_call_set_handler(entry->name, entry->len, mock_settings_read, entry, arg);
+        }
+    }
+
+    return 0;
+}
+
+static int mock_settings_save(struct settings_store *cs, const char *name, const char *value,
+                              size_t val_len) {
+    struct mock_settings_entry *free_entry = NULL;
+
+    if (strlen(name) >= MOCK_SETTINGS_NAME_LEN || val_len > MOCK_SETTINGS_VALUE_LEN) {
+        return -ENOMEM;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(mock_settings_entries); i++) {
+        struct mock_settings_entry *entry = &mock_settings_entries[i];
+
+        if (strcmp(entry->name, name) == 0) {
+            free_entry = entry;
+            break;
+        } else if (free_entry == NULL && entry->name[0] == '\0') {
+            free_entry = entry;
+        }
+    }
+
+    if (free_entry == NULL) {
+        return -ENOMEM;
+    }
+
+    // A zero length value deletes the setting.
+    if (val_len == 0) {
+        free_entry->name[0] = '\0';
+        return 0;
+    }
+
+    strcpy(free_entry->name, name);
+    memcpy(free_entry->value, value, val_len);
+    free_entry->len = val_len;
+
+    return 0;
+}
+
+static const struct settings_store_itf mock_settings_itf = {
+    .csi_load = mock_settings_load,
+    .csi_save = mock_settings_save,
+};
+
+static struct settings_store mock_settings_store = {.cs_itf = &mock_settings_itf};
+
+int settings_backend_init(void) {
+    settings_src_register(&mock_settings_store);
+    settings_dst_register(&mock_settings_store);
+
+    return 0;
+}
+
+#endif // IS_ENABLED(CONFIG_SETTINGS_CUSTOM)
+
+static int keymap_update_mock_init(void) {
+    keymap_update_mock_schedule_next();
+
+    return 0;
+}
+
+SYS_INIT(keymap_update_mock_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -6,10 +6,16 @@
 
 #define DT_DRV_COMPAT zmk_input_listener
 
+#include <string.h>
+
 #include <zephyr/device.h>
+#include <zephyr/init.h>
 #include <zephyr/kernel.h>
 #include <zephyr/input/input.h>
 #include <zephyr/dt-bindings/input/input-event-codes.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #include <zmk/mouse.h>
 #include <zmk/endpoints.h>
@@ -23,16 +29,40 @@ enum input_listener_xy_data_mode {
 
 struct input_listener_xy_data {
     enum input_listener_xy_data_mode mode;
-    int16_t x;
-    int16_t y;
+    int32_t x;
+    int32_t y;
 };
 
+#define INPUT_LISTENER_BUTTON_QUEUE_LEN 4
+
 struct input_listener_data {
+    /* Protects the accumulated input, pacing and counters, shared with the flush work. */
+    struct k_spinlock lock;
     struct input_listener_xy_data data;
     struct input_listener_xy_data wheel_data;
 
-    uint8_t button_set;
-    uint8_t button_clear;
+    /* Buttons as of the latest input, and which of them changed since the last state was queued
+     * or sent. When a button changes again before its last change went out, the state before the
+     * new change is queued, so each transition gets a report of its own and a click that starts
+     * and ends between two reports still reaches the host.
+     */
+    uint8_t buttons;
+    uint8_t buttons_changed;
+    uint8_t button_queue[INPUT_LISTENER_BUTTON_QUEUE_LEN];
+    uint8_t button_queue_len;
+    /* Buttons in the last report sent, only used by the flush work. */
+    uint8_t buttons_sent;
+
+    /* Sends accumulated input once the endpoint can take the next report. */
+    struct k_work_delayable flush_work;
+    /* Uptime in ticks before which another report would only queue up behind the last one. */
+    int64_t next_report_ticks;
+
+    /* Counters for the debug log, reset every second. */
+    uint32_t syncs;
+    uint32_t reports;
+    uint32_t saturated;
+    int64_t stats_start_ticks;
 };
 
 struct input_listener_config {
@@ -68,6 +98,7 @@ static void handle_rel_code(struct input_listener_data *data, struct input_event
 
 static void handle_key_code(struct input_listener_data *data, struct input_event *evt) {
     int8_t btn;
+    bool pressed;
 
     switch (evt->code) {
     case INPUT_BTN_0:
@@ -76,11 +107,20 @@ static void handle_key_code(struct input_listener_data *data, struct input_event
     case INPUT_BTN_3:
     case INPUT_BTN_4:
         btn = evt->code - INPUT_BTN_0;
-        if (evt->value > 0) {
-            WRITE_BIT(data->button_set, btn, 1);
-        } else {
-            WRITE_BIT(data->button_clear, btn, 1);
+        pressed = evt->value > 0;
+        if (((data->buttons & BIT(btn)) != 0) == pressed) {
+            break;
+        }
+
+        // With the queue full, the change is folded into the last state instead.
+        if ((data->buttons_changed & BIT(btn)) != 0 &&
+            data->button_queue_len < ARRAY_SIZE(data->button_queue)) {
+            data->button_queue[data->button_queue_len++] = data->buttons;
+            data->buttons_changed = 0;
         }
+
+        WRITE_BIT(data->buttons, btn, pressed);
+        data->buttons_changed |= BIT(btn);
         break;
     default:
         break;
@@ -116,58 +156,172 @@ static void filter_with_input_config(const struct input_listener_config *cfg,
     evt->value = (int16_t)((evt->value * cfg->scale_multiplier) / cfg->scale_divisor);
 }
 
-static void clear_xy_data(struct input_listener_xy_data *data) {
-    data->x = data->y = 0;
-    data->mode = INPUT_LISTENER_XY_DATA_MODE_NONE;
+/**
+ * Take as much of the accumulated movement as fits in one report, leaving the rest to be sent by
+ * later reports.
+ *
+ * @returns true if the accumulated movement did not fit.
+ */
+static bool take_xy_data(struct input_listener_xy_data *data, struct input_listener_xy_data *out) {
+    *out = (struct input_listener_xy_data){
+        .mode = data->mode,
+        .x = CLAMP(data->x, -ZMK_HID_MOUSE_DELTA_MAX, ZMK_HID_MOUSE_DELTA_MAX),
+        .y = CLAMP(data->y, -ZMK_HID_MOUSE_DELTA_MAX, ZMK_HID_MOUSE_DELTA_MAX),
+    };
+
+    data->x -= out->x;
+    data->y -= out->y;
+
+    if (data->x == 0 && data->y == 0) {
+        data->mode = INPUT_LISTENER_XY_DATA_MODE_NONE;
+        return false;
+    }
+
+    return true;
 }
 
-static void input_handler(const struct input_listener_config *config,
-                          struct input_listener_data *data, struct input_event *evt) {
-    // First, filter to update the event data as needed.
-    filter_with_input_config(config, evt);
+static void log_stats(struct input_listener_data *data, int64_t now) {
+    uint32_t syncs, reports, saturated;
 
-    switch (evt->type) {
-    case INPUT_EV_REL:
-        handle_rel_code(data, evt);
-        break;
-    case INPUT_EV_KEY:
-        handle_key_code(data, evt);
-        break;
+    K_SPINLOCK(&data->lock) {
+        syncs = data->syncs;
+        reports = data->reports;
+        saturated = data->saturated;
+
+        if (now - data->stats_start_ticks < k_ms_to_ticks_ceil64(MSEC_PER_SEC)) {
+            syncs = reports = saturated = 0;
+            K_SPINLOCK_BREAK;
+        }
+
+        data->syncs = data->reports = data->saturated = 0;
+        data->stats_start_ticks = now;
     }
 
-    if (evt->sync) {
-        if (data->wheel_data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_scroll_set(data->wheel_data.x, data->wheel_data.y);
+    if (syncs > reports || saturated > 0) {
+        LOG_DBG("%u syncs sent as %u reports, %u saturated", syncs, reports, saturated);
+    }
+}
+
+/* Only ever run from the flush work, so reports are built and sent from a single context. */
+static void flush(struct input_listener_data *data) {
+    struct input_listener_xy_data xy = {0}, wheel = {0};
+    uint8_t buttons;
+    bool carry = false;
+    bool queued = false;
+
+    K_SPINLOCK(&data->lock) {
+        carry = take_xy_data(&data->data, &xy);
+        carry |= take_xy_data(&data->wheel_data, &wheel);
+
+        if (data->button_queue_len > 0) {
+            buttons = data->button_queue[0];
+            data->button_queue_len--;
+            memmove(&data->button_queue[0], &data->button_queue[1], data->button_queue_len);
+            queued = true;
+        } else {
+            buttons = data->buttons;
+            data->buttons_changed = 0;
         }
+    }
+
+    const uint8_t button_press = buttons & ~data->buttons_sent;
+    const uint8_t button_release = data->buttons_sent & ~buttons;
 
-        if (data->data.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
-            zmk_hid_mouse_movement_set(data->data.x, data->data.y);
+    if (xy.mode == INPUT_LISTENER_XY_DATA_MODE_NONE &&
+        wheel.mode == INPUT_LISTENER_XY_DATA_MODE_NONE && button_press == 0 &&
+        button_release == 0 && !queued) {
+        return;
+    }
+
+    if (wheel.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        zmk_hid_mouse_scroll_set(wheel.x, wheel.y);
+    }
+
+    if (xy.mode == INPUT_LISTENER_XY_DATA_MODE_REL) {
+        zmk_hid_mouse_movement_set(xy.x, xy.y);
+    }
+
+    for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
+        if ((button_press & BIT(i)) != 0) {
+            zmk_hid_mouse_button_press(i);
+        } else if ((button_release & BIT(i)) != 0) {
+            zmk_hid_mouse_button_release(i);
         }
+    }
+    data->buttons_sent = buttons;
 
-        if (data->button_set != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->button_set & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_press(i);
-                }
-            }
+    zmk_endpoints_send_mouse_report();
+    LOG_DBG("Sent report with buttons 0x%02X", buttons);
+    zmk_hid_mouse_scroll_set(0, 0);
+    zmk_hid_mouse_movement_set(0, 0);
+
+    const int64_t now = k_uptime_ticks();
+    const int64_t next_report_ticks =
+        now + k_us_to_ticks_ceil64(zmk_endpoints_mouse_report_interval_us());
+
+    K_SPINLOCK(&data->lock) {
+        data->next_report_ticks = next_report_ticks;
+        data->reports++;
+        if (carry) {
+            data->saturated++;
         }
+    }
+
+    if (carry || queued) {
+        k_work_schedule(&data->flush_work, K_TIMEOUT_ABS_TICKS(next_report_ticks));
+    }
+
+    log_stats(data, now);
+}
+
+static void flush_work_handler(struct k_work *work) {
+    struct k_work_delayable *d_work = k_work_delayable_from_work(work);
+    struct input_listener_data *data = CONTAINER_OF(d_work, struct input_listener_data, flush_work);
 
-        if (data->button_clear != 0) {
-            for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                if ((data->button_clear & BIT(i)) != 0) {
-                    zmk_hid_mouse_button_release(i);
-                }
-            }
+    flush(data);
+}
+
+static void input_handler(const struct input_listener_config *config,
+                          struct input_listener_data *data, struct input_event *evt) {
+    // First, filter to update the event data as needed.
+    filter_with_input_config(config, evt);
+
+    bool send_now = false;
+    int64_t next_report_ticks = 0;
+
+    K_SPINLOCK(&data->lock) {
+        switch (evt->type) {
+        case INPUT_EV_REL:
+            handle_rel_code(data, evt);
+            break;
+        case INPUT_EV_KEY:
+            handle_key_code(data, evt);
+            break;
         }
 
-        zmk_endpoints_send_mouse_report();
-        zmk_hid_mouse_scroll_set(0, 0);
-        zmk_hid_mouse_movement_set(0, 0);
+        if (!evt->sync) {
+            K_SPINLOCK_BREAK;
+        }
+
+        data->syncs++;
 
-        clear_xy_data(&data->data);
-        clear_xy_data(&data->wheel_data);
+        // Movement is summed until the endpoint is ready for another report, so a pointing device
+        // that syncs faster than the link can send doesn't queue up stale reports. Button changes
+        // are sent right away.
+        next_report_ticks = data->next_report_ticks;
+        send_now = data->buttons_changed != 0 || data->button_queue_len > 0 ||
+                   k_uptime_ticks() >= next_report_ticks;
+    }
 
-        data->button_set = data->button_clear = 0;
+    if (!evt->sync) {
+        return;
+    }
+
+    if (send_now) {
+        // Pulls in a flush that was waiting for the report interval to pass.
+        k_work_reschedule(&data->flush_work, K_NO_WAIT);
+    } else {
+        k_work_schedule(&data->flush_work, K_TIMEOUT_ABS_TICKS(next_report_ticks));
     }
 }
 
@@ -183,6 +337,11 @@ static void input_handler(const struct input_listener_config *config,
     void input_handler_##n(struct input_event *evt) {                                              \
         input_handler(&config_##n, &data_##n, evt);                                                \
     }                                                                                              \
-    INPUT_CALLBACK_DEFINE(DEVICE_DT_GET(DT_INST_PHANDLE(n, device)), input_handler_##n);
+    INPUT_CALLBACK_DEFINE(DEVICE_DT_GET(DT_INST_PHANDLE(n, device)), input_handler_##n);        \
+    static int input_listener_init_##n(void) {                                                     \
+        k_work_init_delayable(&data_##n.flush_work, flush_work_handler);                           \
+        return 0;                                                                                  \
+    }                                                                                              \
+    SYS_INIT(input_listener_init_##n, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
 
 DT_INST_FOREACH_STATUS_OKAY(IL_INST)
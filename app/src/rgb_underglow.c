@@ -9,13 +9,14 @@
 #include <zephyr/kernel.h>
 #include <zephyr/settings/settings.h>
 
-#include <math.h>
 #include <stdlib.h>
 
 #include <zmk/battery.h>
 #include <zmk/ble.h>
 #include <zmk/endpoints.h>
 #include <zmk/keymap.h>
+#include <zmk/led_color.h>
+#include <zmk/led_output.h>
 #include <zmk/hid_indicators.h>
 #include <zmk/usb.h>
 
@@ -29,6 +30,11 @@
 #include <zmk/activity.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/activity_state_changed.h>
+#include <zmk/events/battery_state_changed.h>
+#include <zmk/events/ble_active_profile_changed.h>
+#include <zmk/events/endpoint_changed.h>
+#include <zmk/events/hid_indicators_changed.h>
+#include <zmk/events/layer_state_changed.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/workqueue.h>
 
@@ -55,12 +61,6 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #define SAT_MAX 100
 #define BRT_MAX 100
 
-#define LAYER_GAMING 1
-#define LAYER_ARROW_GAMING 2
-#define LAYER_MOUSE 3
-#define LAYER_LOWER 4
-#define LAYER_NUMERIC 5
-
 BUILD_ASSERT(CONFIG_ZMK_RGB_UNDERGLOW_BRT_MIN <= CONFIG_ZMK_RGB_UNDERGLOW_BRT_MAX,
              "ERROR: RGB underglow maximum brightness is less than minimum brightness");
 
@@ -86,8 +86,23 @@ struct rgb_underglow_state {
 static const struct device *led_strip;
 
 static struct led_rgb pixels[STRIP_NUM_PIXELS];
+// Frames are clocked out from here, so the low priority work queue never waits for the strip.
+ZMK_LED_OUTPUT_DEFINE(underglow_output, STRIP_NUM_PIXELS);
 static struct led_rgb status_pixels[STRIP_NUM_PIXELS];
 
+// Parts of status_pixels that are drawn from separate state, so an event only redraws its own.
+enum status_section {
+    STATUS_BATTERY = BIT(0),
+    STATUS_HID_INDICATORS = BIT(1),
+    STATUS_LAYERS = BIT(2),
+    STATUS_CONNECTION = BIT(3),
+};
+
+#define STATUS_ALL (STATUS_BATTERY | STATUS_HID_INDICATORS | STATUS_LAYERS | STATUS_CONNECTION)
+
+// Sections whose state changed since status_pixels was last drawn.
+static atomic_t status_stale = ATOMIC_INIT(STATUS_ALL);
+
 static struct rgb_underglow_state state;
 
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_EXT_POWER)
@@ -108,52 +123,7 @@ static struct zmk_led_hsb hsb_scale_zero_max(struct zmk_led_hsb hsb) {
 }
 
 static struct led_rgb hsb_to_rgb(struct zmk_led_hsb hsb) {
-    float r, g, b;
-
-    uint8_t i = hsb.h / 60;
-    float v = hsb.b / ((float)BRT_MAX);
-    float s = hsb.s / ((float)SAT_MAX);
-    float f = hsb.h / ((float)HUE_MAX) * 6 - i;
-    float p = v * (1 - s);
-    float q = v * (1 - f * s);
-    float t = v * (1 - (1 - f) * s);
-
-    switch (i % 6) {
-    case 0:
-        r = v;
-        g = t;
-        b = p;
-        break;
-    case 1:
-        r = q;
-        g = v;
-        b = p;
-        break;
-    case 2:
-        r = p;
-        g = v;
-        b = t;
-        break;
-    case 3:
-        r = p;
-        g = q;
-        b = v;
-        break;
-    case 4:
-        r = t;
-        g = p;
-        b = v;
-        break;
-    case 5:
-        r = v;
-        g = p;
-        b = q;
-        break;
-    }
-
-    struct led_rgb rgb = {r : r * 255, g : g * 255, b : b * 255};
-
-    return rgb;
+    return zmk_led_hsb_to_rgb(hsb.h, hsb.s, hsb.b);
 }
 
 static void zmk_rgb_underglow_effect_solid(void) {
@@ -205,6 +175,47 @@ static bool valdur_layer_active(int layer);
 
 static int zmk_led_generate_status(void);
 
+static void zmk_led_log_stats(void) {
+    static int64_t stats_start_ticks;
+    static uint32_t stats_submitted, stats_unchanged;
+    const int64_t now = k_uptime_ticks();
+    uint32_t submitted = 0, unchanged = 0;
+
+    // The output updates its counters under this lock, and frames are pushed from more than one
+    // context, so the counts since the last log are taken under it too.
+    K_SPINLOCK(&underglow_output.lock) {
+        if (now - stats_start_ticks < k_ms_to_ticks_ceil64(MSEC_PER_SEC)) {
+            K_SPINLOCK_BREAK;
+        }
+
+        submitted = underglow_output.frames_submitted - stats_submitted;
+        unchanged = underglow_output.frames_unchanged - stats_unchanged;
+        stats_submitted = underglow_output.frames_submitted;
+        stats_unchanged = underglow_output.frames_unchanged;
+        stats_start_ticks = now;
+    }
+
+    if (submitted > 0) {
+        LOG_DBG("Pushed %u of %u rendered frames", submitted - unchanged, submitted);
+    }
+}
+
+static int zmk_led_push_pixels(struct led_rgb *frame) {
+    // The output skips a frame identical to the last one, which it checks under its own lock, as
+    // frames come from both the tick and the system work queue.
+    int err = zmk_led_output_submit(&underglow_output, frame);
+
+    zmk_led_log_stats();
+
+    return err;
+}
+
+static void zmk_led_output_done(struct zmk_led_output *output, int err) {
+    if (err < 0) {
+        LOG_ERR("Failed to update the RGB strip (%d)", err);
+    }
+}
+
 static void zmk_led_write_pixels(void) {
     static struct led_rgb led_buffer[STRIP_NUM_PIXELS];
     int bat0 = zmk_battery_state_of_charge();
@@ -217,7 +228,7 @@ static void zmk_led_write_pixels(void) {
 
     // fast path: no status indicators, battery level OK
     if (blend == 0 && bat0 >= 20) {
-        led_strip_update_rgb(led_strip, pixels, STRIP_NUM_PIXELS);
+        zmk_led_push_pixels(pixels);
         return;
     }
     // battery below minimum charge
@@ -233,39 +244,14 @@ static void zmk_led_write_pixels(void) {
         }
     }
 
-    if (blend == 0) {
-        for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-            led_buffer[i] = pixels[i];
-        }
-    } else if (blend >= 256) {
-        for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-            led_buffer[i] = status_pixels[i];
-        }
-    } else if (blend < 256) {
-        uint16_t blend_l = blend;
-        uint16_t blend_r = 256 - blend;
-        for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-            led_buffer[i].r =
-                ((status_pixels[i].r * blend_l) >> 8) + ((pixels[i].r * blend_r) >> 8);
-            led_buffer[i].g =
-                ((status_pixels[i].g * blend_l) >> 8) + ((pixels[i].g * blend_r) >> 8);
-            led_buffer[i].b =
-                ((status_pixels[i].b * blend_l) >> 8) + ((pixels[i].b * blend_r) >> 8);
-        }
-    }
-
     // battery below 20%, reduce LED brightness
-    if (bat0 < 20) {
-        for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-            led_buffer[i].r = led_buffer[i].r >> 1;
-            led_buffer[i].g = led_buffer[i].g >> 1;
-            led_buffer[i].b = led_buffer[i].b >> 1;
-        }
-    }
+    const uint16_t scale = bat0 < 20 ? ZMK_LED_WEIGHT_MAX / 2 : ZMK_LED_WEIGHT_MAX;
+
+    zmk_led_blend_scale(led_buffer, status_pixels, pixels, STRIP_NUM_PIXELS, blend, scale);
 
-    int err = led_strip_update_rgb(led_strip, led_buffer, STRIP_NUM_PIXELS);
+    int err = zmk_led_push_pixels(led_buffer);
     if (err < 0) {
-        LOG_ERR("Failed to update the RGB strip (%d)", err);
+        LOG_ERR("Failed to queue an RGB strip update (%d)", err);
     }
 
     if (reset_ext_power) {
@@ -287,6 +273,7 @@ static void zmk_led_write_pixels(void) {
 
 #if !UNDERGLOW_INDICATORS_ENABLED
 static int zmk_led_generate_status(void) { return 0; }
+static void zmk_led_invalidate_status(const zmk_event_t *eh) {}
 static bool valdur_layer_active(int layer) { return peripheral_layer_active(layer); }
 
 #else
@@ -305,6 +292,7 @@ const uint8_t underglow_bat_rhs[] = DT_PROP(UNDERGLOW_INDICATORS, bat_rhs);
         b : (CONFIG_ZMK_RGB_UNDERGLOW_BRT_MAX * (B)) / 0xff                                        \
     })
 
+const struct led_rgb black = HEXRGB(0x00, 0x00, 0x00);
 const struct led_rgb red = HEXRGB(0xff, 0x00, 0x00);
 const struct led_rgb orange = HEXRGB(0xff, 0x88, 0x00);
 const struct led_rgb yellow = HEXRGB(0xff, 0xff, 0x00);
@@ -348,15 +336,12 @@ static void zmk_led_fill(struct led_rgb color, const uint8_t *addresses, size_t
 #define ZMK_LED_CAPSLOCK_BIT BIT(1)
 #define ZMK_LED_SCROLLLOCK_BIT BIT(2)
 
-static int zmk_led_generate_status(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        status_pixels[i] = (struct led_rgb){r : 0, g : 0, b : 0};
-    }
-
-    // BATTERY STATUS
+static void zmk_led_generate_battery_status(void) {
+    zmk_led_fill(black, underglow_bat_lhs, DT_PROP_LEN(UNDERGLOW_INDICATORS, bat_lhs));
     zmk_led_battery_level(zmk_battery_state_of_charge(), underglow_bat_lhs,
                           DT_PROP_LEN(UNDERGLOW_INDICATORS, bat_lhs));
 
+    zmk_led_fill(black, underglow_bat_rhs, DT_PROP_LEN(UNDERGLOW_INDICATORS, bat_rhs));
 #if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
     uint8_t peripheral_level = 0;
     int rc = zmk_split_get_peripheral_battery_level(0, &peripheral_level);
@@ -370,27 +355,30 @@ static int zmk_led_generate_status(void) {
         LOG_ERR("Invalid peripheral index requested for battery level read: 0");
     }
 #endif
+}
 
-    // CAPSLOCK/NUMLOCK/SCROLLOCK STATUS
+static void zmk_led_generate_hid_indicators_status(void) {
     zmk_hid_indicators_t led_flags = zmk_hid_indicators_get_current_profile();
 
-    if (led_flags & ZMK_LED_CAPSLOCK_BIT)
-        status_pixels[DT_PROP(UNDERGLOW_INDICATORS, capslock)] = yellow;
-    if (led_flags & ZMK_LED_NUMLOCK_BIT)
-        status_pixels[DT_PROP(UNDERGLOW_INDICATORS, numlock)] = yellow;
-    if (led_flags & ZMK_LED_SCROLLLOCK_BIT)
-        status_pixels[DT_PROP(UNDERGLOW_INDICATORS, scrolllock)] = yellow;
+    status_pixels[DT_PROP(UNDERGLOW_INDICATORS, capslock)] =
+        (led_flags & ZMK_LED_CAPSLOCK_BIT) ? yellow : black;
+    status_pixels[DT_PROP(UNDERGLOW_INDICATORS, numlock)] =
+        (led_flags & ZMK_LED_NUMLOCK_BIT) ? yellow : black;
+    status_pixels[DT_PROP(UNDERGLOW_INDICATORS, scrolllock)] =
+        (led_flags & ZMK_LED_SCROLLLOCK_BIT) ? yellow : black;
+}
 
-    // LAYER STATUS
+static void zmk_led_generate_layers_status(void) {
     for (uint8_t i = 0; i < DT_PROP_LEN(UNDERGLOW_INDICATORS, layer_state); i++) {
-        if (zmk_keymap_layer_active(i))
-            status_pixels[underglow_layer_state[i]] = lilac;
+        status_pixels[underglow_layer_state[i]] = zmk_keymap_layer_active(i) ? lilac : black;
     }
+}
 
+static void zmk_led_generate_connection_status(void) {
     struct zmk_endpoint_instance active_endpoint = zmk_endpoints_selected();
 
-    if (!zmk_endpoints_preferred_transport_is_active())
-        status_pixels[DT_PROP(UNDERGLOW_INDICATORS, output_fallback)] = red;
+    status_pixels[DT_PROP(UNDERGLOW_INDICATORS, output_fallback)] =
+        zmk_endpoints_preferred_transport_is_active() ? black : red;
 
     int active_ble_profile_index = zmk_ble_active_profile_index();
     for (uint8_t i = 0;
@@ -406,6 +394,8 @@ static int zmk_led_generate_status(void) {
             status_pixels[ble_pixel] = red;
         } else if (status == 0) { // unused
             status_pixels[ble_pixel] = lilac;
+        } else {
+            status_pixels[ble_pixel] = black;
         }
     }
 
@@ -419,6 +409,71 @@ static int zmk_led_generate_status(void) {
         status_pixels[DT_PROP(UNDERGLOW_INDICATORS, usb_state)] = red;
     } else if (usb_state == ZMK_USB_CONN_NONE) { // disconnected
         status_pixels[DT_PROP(UNDERGLOW_INDICATORS, usb_state)] = lilac;
+    } else {
+        status_pixels[DT_PROP(UNDERGLOW_INDICATORS, usb_state)] = black;
+    }
+}
+
+static void zmk_led_invalidate_status(const zmk_event_t *eh) {
+    atomic_val_t sections = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+    if (as_zmk_battery_state_changed(eh)) {
+        sections |= STATUS_BATTERY;
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+    if (as_zmk_peripheral_battery_state_changed(eh)) {
+        sections |= STATUS_BATTERY;
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+    if (as_zmk_hid_indicators_changed(eh)) {
+        sections |= STATUS_HID_INDICATORS;
+    }
+#endif
+
+    if (as_zmk_layer_state_changed(eh)) {
+        sections |= STATUS_LAYERS;
+    }
+
+    // The HID indicators shown are those of the active profile or endpoint.
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    if (as_zmk_ble_active_profile_changed(eh)) {
+        sections |= STATUS_HID_INDICATORS | STATUS_CONNECTION;
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+    if (as_zmk_usb_conn_state_changed(eh)) {
+        sections |= STATUS_CONNECTION;
+    }
+#endif
+
+    if (as_zmk_endpoint_changed(eh)) {
+        sections |= STATUS_HID_INDICATORS | STATUS_CONNECTION;
+    }
+
+    atomic_or(&status_stale, sections);
+}
+
+static int zmk_led_generate_status(void) {
+    // Only redraw the sections whose state changed, so a frame of the fade costs just the blend.
+    const atomic_val_t stale = atomic_clear(&status_stale);
+
+    if (stale & STATUS_BATTERY) {
+        zmk_led_generate_battery_status();
+    }
+    if (stale & STATUS_HID_INDICATORS) {
+        zmk_led_generate_hid_indicators_status();
+    }
+    if (stale & STATUS_LAYERS) {
+        zmk_led_generate_layers_status();
+    }
+    if (stale & STATUS_CONNECTION) {
+        zmk_led_generate_connection_status();
     }
 
     int16_t blend = 256;
@@ -436,166 +491,79 @@ static int zmk_led_generate_status(void) {
 }
 #endif // underglow_indicators exists
 
-static inline struct led_rgb hue_sat(int hue, int sat) {
-    struct zmk_led_hsb hsb = state.color;
-    hsb.h = hue;
-    hsb.s = sat;
-    return hsb_to_rgb(hsb_scale_min_max(hsb));
-}
-
-#define MK_GREEN hue_sat(150, 100)
-#define MK_RED hue_sat(348, 100)
-#define MK_BLUE hue_sat(194, 100)
-#define MK_ORANGE hue_sat(20, 100)
-#define MK_YELLOW hue_sat(51, 100)
-#define MK_PURPLE hue_sat(267, 60)
-#define MK_WHITE hue_sat(0, 0);
+#define LAYER_INDICATORS DT_CHOSEN(zmk_underglow_layer_indicators)
 
-/*
-  MoErgo 40 LEDs
-
- 34 28 22 16 10                10 16 22 28 34
- 35 29 23 17 11 6            6 11 17 23 29 35
- 36 30 24 18 12 7            7 12 18 24 30 36
- 37 31 25 19 13 8            8 13 19 25 31 37
- 38 32 26 20 14 9            9 14 20 26 32 38
- 39 33 27 21 15                15 21 27 33 39
-               0 1 2       2 1 0
-               3 4 5       5 4 3
-*/
-
-static void valdur_indicate_custom_layers(void) {
-    for (int i = 0; i < STRIP_NUM_PIXELS; i++) {
-        pixels[i] = (struct led_rgb){r : 0, g : 0, b : 0};
-    }
-    if (valdur_layer_active(LAYER_NUMERIC)) {
-        struct led_rgb col_green = MK_GREEN;
-        struct led_rgb col_yellow = MK_YELLOW;
-
-#ifdef LEFT_HALF
-        // indicator
-        pixels[36] = col_green;
+#if IS_ENABLED(CONFIG_ZMK_SPLIT) && !IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+#define LAYER_INDICATOR_PIXELS peripheral_pixels
+#else
+#define LAYER_INDICATOR_PIXELS pixels
 #endif
 
-        // numbers
-        pixels[12] = col_green;
-        pixels[13] = col_green;
-        pixels[14] = col_green;
-#ifdef RIGHT_HALF
-        pixels[15] = col_green;
-#endif
+BUILD_ASSERT(STRIP_NUM_PIXELS <= 64, "Layer indicator pixel masks hold at most 64 pixels");
 
-        pixels[18] = col_green;
-        pixels[19] = col_green;
-        pixels[20] = col_green;
+struct layer_indicator {
+    uint8_t layer;
+    uint16_t hue;
+    uint8_t saturation;
+    // Pixels to light on this half, one bit per pixel.
+    uint64_t pixels;
+};
 
-        pixels[24] = col_green;
-        pixels[25] = col_green;
-        pixels[26] = col_green;
-#ifdef LEFT_HALF
-        pixels[27] = col_green;
+#define LAYER_INDICATOR_PIXEL_BIT(node, prop, idx) BIT64(DT_PROP_BY_IDX(node, prop, idx)) |
+
+#define LAYER_INDICATOR(node)                                                                      \
+    {                                                                                              \
+        .layer = DT_PROP(node, layer),                                                             \
+        .hue = DT_PROP(node, hue),                                                                 \
+        .saturation = DT_PROP(node, saturation),                                                   \
+        .pixels = COND_CODE_1(DT_NODE_HAS_PROP(node, LAYER_INDICATOR_PIXELS),                      \
+                              (DT_FOREACH_PROP_ELEM(node, LAYER_INDICATOR_PIXELS,                  \
+                                                    LAYER_INDICATOR_PIXEL_BIT) 0),                 \
+                              (0)),                                                                \
+    },
+
+#define LAYER_INDICATOR_PIXEL_CHECK(node, prop, idx)                                               \
+    BUILD_ASSERT(DT_PROP_BY_IDX(node, prop, idx) < STRIP_NUM_PIXELS,                               \
+                 "Layer indicator pixel is past the end of the strip");
+
+#define LAYER_INDICATOR_CHECK(node)                                                                \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, LAYER_INDICATOR_PIXELS),                                    \
+                (DT_FOREACH_PROP_ELEM(node, LAYER_INDICATOR_PIXELS, LAYER_INDICATOR_PIXEL_CHECK)), \
+                ())
+
+#if DT_HAS_CHOSEN(zmk_underglow_layer_indicators)
+DT_FOREACH_CHILD(LAYER_INDICATORS, LAYER_INDICATOR_CHECK)
+
+static const struct layer_indicator layer_indicators[] = {
+    DT_FOREACH_CHILD(LAYER_INDICATORS, LAYER_INDICATOR)};
+#else
+static const struct layer_indicator layer_indicators[] = {};
 #endif
 
-        // // operators
-        // pixels[31] = col_yellow;
-        // pixels[32] = col_yellow;
-        // pixels[27] = col_yellow;
+static void zmk_rgb_underglow_effect_layer_indicators(void) {
+    memset(pixels, 0, sizeof(pixels));
 
-        // pixels[7] = col_yellow;
-        // pixels[8] = col_yellow;
-        // pixels[9] = col_yellow;
+    // Only one layer is shown at a time: the first in table order that is active.
+    int shown = -1;
 
-    } else if (valdur_layer_active(LAYER_LOWER)) {
-        struct led_rgb col_orange = MK_ORANGE;
-        struct led_rgb col_blue = MK_BLUE;
-
-#ifdef LEFT_HALF
-        // indicator
-        pixels[37] = col_orange;
-#endif
-
-        // arrows
-        pixels[18] = col_orange;
-        pixels[25] = col_orange;
-        pixels[19] = col_orange;
-        pixels[13] = col_orange;
-
-        // // ctrl arrows
-        // pixels[8] = yellow;
-        // pixels[31] = yellow;
-
-        // home, end, pgup, pgdn
-        pixels[7] = col_blue;
-        pixels[8] = col_blue;
-        pixels[24] = col_blue;
-        pixels[12] = col_blue;
-    } else if (valdur_layer_active(LAYER_MOUSE)) {
-        struct led_rgb col_red = MK_RED;
-        struct led_rgb col_blue = MK_BLUE;
-        struct led_rgb col_purple = MK_PURPLE;
-
-#ifdef LEFT_HALF
-        // indicator
-        pixels[38] = col_blue;
-#else
-
-        // movement
-        pixels[13] = col_blue;
-        pixels[18] = col_blue;
-        pixels[19] = col_blue;
-        pixels[25] = col_blue;
-
-
-        // scrolling
-        pixels[8] = col_purple;
-        pixels[9] = col_purple;
-        pixels[24] = col_purple;
-        pixels[12] = col_purple;
-
-        // buttons
-        pixels[3] = col_red;
-        pixels[4] = col_red;
-        pixels[14] = col_red;
-        pixels[26] = col_red;
-        pixels[31] = col_red;
-#endif
-    } else if (valdur_layer_active(LAYER_GAMING)) {
-        struct led_rgb col_red = MK_RED;
-        struct led_rgb col_blue = MK_BLUE;
-#ifdef LEFT_HALF
-
-        // wsad
-        pixels[18] = col_red;
-        pixels[25] = col_red;
-        pixels[19] = col_red;
-        pixels[13] = col_red;
-
-        // enter, backspace, delete
-        pixels[5] = col_blue;
-        pixels[33] = col_blue;
-#else
-        pixels[6] = col_red;
-#endif
-    } else if (valdur_layer_active(LAYER_ARROW_GAMING)) {
-        struct led_rgb col_red = MK_RED;
-        struct led_rgb col_blue = MK_BLUE;
-        struct led_rgb col_yellow = MK_YELLOW;
+    for (int i = 0; i < ARRAY_SIZE(layer_indicators); i++) {
+        const struct layer_indicator *indicator = &layer_indicators[i];
+        if (shown < 0 && valdur_layer_active(indicator->layer)) {
+            shown = indicator->layer;
+        }
 
-#ifdef LEFT_HALF
+        if (indicator->layer != shown) {
+            continue;
+        }
 
-        // enter, backspace, delete
-        pixels[19] = col_red;
-        pixels[13] = col_blue;
-#else
-        // wsad
-        pixels[18] = col_yellow;
-        pixels[25] = col_yellow;
-        pixels[19] = col_yellow;
-        pixels[13] = col_yellow;
-#endif
-    } else {
-        pixels[6] = MK_BLUE;
+        struct zmk_led_hsb hsb = state.color;
+        hsb.h = indicator->hue;
+        hsb.s = indicator->saturation;
+        const struct led_rgb color = hsb_to_rgb(hsb_scale_min_max(hsb));
 
+        for (uint64_t remaining = indicator->pixels; remaining; remaining &= remaining - 1) {
+            pixels[u64_count_trailing_zeros(remaining)] = color;
+        }
     }
 }
 
@@ -614,7 +582,7 @@ static void zmk_rgb_underglow_tick(struct k_work *work) {
         zmk_rgb_underglow_effect_swirl();
         break;
     case UNDERGLOW_EFFECT_LAYER_INDICATORS:
-        valdur_indicate_custom_layers();
+        zmk_rgb_underglow_effect_layer_indicators();
         break;
     }
 
@@ -633,6 +601,33 @@ static void zmk_rgb_underglow_tick_handler(struct k_timer *timer) {
 
 K_TIMER_DEFINE(underglow_tick, zmk_rgb_underglow_tick_handler, NULL);
 
+static bool zmk_rgb_underglow_effect_is_animated(void) {
+    switch (state.current_effect) {
+    case UNDERGLOW_EFFECT_BREATHE:
+    case UNDERGLOW_EFFECT_SPECTRUM:
+    case UNDERGLOW_EFFECT_SWIRL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Static effects only change with their inputs, so render them once instead of on every tick.
+static void zmk_rgb_underglow_redraw(void) {
+    if (state.on && !zmk_rgb_underglow_effect_is_animated()) {
+        k_work_submit_to_queue(zmk_workqueue_lowprio_work_q(), &underglow_tick_work);
+    }
+}
+
+static void zmk_rgb_underglow_start_rendering(void) {
+    if (zmk_rgb_underglow_effect_is_animated()) {
+        k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(25));
+    } else {
+        k_timer_stop(&underglow_tick);
+        zmk_rgb_underglow_redraw();
+    }
+}
+
 #if IS_ENABLED(CONFIG_SETTINGS)
 static int rgb_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg) {
     const char *next;
@@ -666,6 +661,12 @@ static struct k_work_delayable underglow_save_work;
 static int zmk_rgb_underglow_init(void) {
     led_strip = DEVICE_DT_GET(STRIP_CHOSEN);
 
+    int rc = zmk_led_output_init(&underglow_output, led_strip, zmk_led_output_done);
+    if (rc < 0) {
+        LOG_ERR("LED strip device %s is not ready", led_strip->name);
+        return rc;
+    }
+
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_EXT_POWER)
     if (!device_is_ready(ext_power)) {
         LOG_ERR("External power device \"%s\" is not ready", ext_power->name);
@@ -704,7 +705,7 @@ static int zmk_rgb_underglow_init(void) {
 #endif
 
     if (state.on) {
-        k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(25));
+        zmk_rgb_underglow_start_rendering();
     }
 
     return 0;
@@ -744,6 +745,8 @@ void zmk_rgb_set_ext_power(void) {
         }
     }
     if (desired_state && !c_power) {
+        // The strip loses its frame while unpowered.
+        zmk_led_output_invalidate(&underglow_output);
         int rc = ext_power_enable(ext_power);
         if (rc != 0) {
             LOG_ERR("Unable to enable EXT_POWER: %d", rc);
@@ -765,7 +768,7 @@ int zmk_rgb_underglow_on(void) {
     zmk_rgb_set_ext_power();
 
     state.animation_step = 0;
-    k_timer_start(&underglow_tick, K_NO_WAIT, K_MSEC(25));
+    zmk_rgb_underglow_start_rendering();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -807,6 +810,10 @@ int zmk_rgb_underglow_select_effect(int effect) {
     state.current_effect = effect;
     state.animation_step = 0;
 
+    if (state.on) {
+        zmk_rgb_underglow_start_rendering();
+    }
+
     return zmk_rgb_underglow_save_state();
 }
 
@@ -846,6 +853,9 @@ static void zmk_led_write_pixels_work(struct k_work *work) {
 int zmk_rgb_underglow_status(void) {
     if (!state.status_active) {
         state.status_animation_step = 0;
+        // Not every input raises an event, such as the pairing state of inactive profiles, so a
+        // new status display starts from a full redraw.
+        atomic_set(&status_stale, STATUS_ALL);
     } else {
         if (state.status_animation_step > (500 / 25)) {
             state.status_animation_step = 500 / 25;
@@ -866,6 +876,7 @@ int zmk_rgb_underglow_set_hsb(struct zmk_led_hsb color) {
     }
 
     state.color = color;
+    zmk_rgb_underglow_redraw();
 
     return 0;
 }
@@ -907,6 +918,7 @@ int zmk_rgb_underglow_change_hue(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_hue(direction);
+    zmk_rgb_underglow_redraw();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -916,6 +928,7 @@ int zmk_rgb_underglow_change_sat(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_sat(direction);
+    zmk_rgb_underglow_redraw();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -925,6 +938,7 @@ int zmk_rgb_underglow_change_brt(int direction) {
         return -ENODEV;
 
     state.color = zmk_rgb_underglow_calc_brt(direction);
+    zmk_rgb_underglow_redraw();
 
     return zmk_rgb_underglow_save_state();
 }
@@ -962,8 +976,11 @@ static int rgb_underglow_auto_state(bool *prev_state, bool new_state) {
         return zmk_rgb_underglow_off();
     }
 }
+#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_IDLE) ||
+       // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_USB)
 
 static int rgb_underglow_event_listener(const zmk_event_t *eh) {
+    zmk_led_invalidate_status(eh);
 
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_IDLE)
     if (as_zmk_activity_state_changed(eh)) {
@@ -980,19 +997,43 @@ static int rgb_underglow_event_listener(const zmk_event_t *eh) {
     }
 #endif
 
-    return -ENOTSUP;
+    // Everything else is an input to the layer indicators or the status overlay.
+    zmk_rgb_underglow_redraw();
+
+    return ZMK_EV_EVENT_BUBBLE;
 }
 
 ZMK_LISTENER(rgb_underglow, rgb_underglow_event_listener);
-#endif // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_IDLE) ||
-       // IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_USB)
 
 #if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_IDLE)
 ZMK_SUBSCRIPTION(rgb_underglow, zmk_activity_state_changed);
 #endif
 
-#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_USB)
+#if IS_ENABLED(CONFIG_ZMK_RGB_UNDERGLOW_AUTO_OFF_USB) ||                                           \
+    (UNDERGLOW_INDICATORS_ENABLED && IS_ENABLED(CONFIG_USB_DEVICE_STACK))
 ZMK_SUBSCRIPTION(rgb_underglow, zmk_usb_conn_state_changed);
 #endif
 
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_layer_state_changed);
+
+#if IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_hid_indicators_changed);
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_battery_state_changed);
+#endif
+
+#if UNDERGLOW_INDICATORS_ENABLED && IS_ENABLED(CONFIG_ZMK_SPLIT_BLE_CENTRAL_BATTERY_LEVEL_FETCHING)
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_peripheral_battery_state_changed);
+#endif
+
+#if UNDERGLOW_INDICATORS_ENABLED && IS_ENABLED(CONFIG_ZMK_BLE)
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_ble_active_profile_changed);
+#endif
+
+#if !IS_ENABLED(CONFIG_ZMK_SPLIT) || IS_ENABLED(CONFIG_ZMK_SPLIT_ROLE_CENTRAL)
+ZMK_SUBSCRIPTION(rgb_underglow, zmk_endpoint_changed);
+#endif
+
 SYS_INIT(zmk_rgb_underglow_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
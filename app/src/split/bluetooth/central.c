@@ -21,6 +21,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #include <zmk/stdlib.h>
 #include <zmk/ble.h>
 #include <zmk/behavior.h>
+#include <zmk/keymap.h>
 #include <zmk/sensors.h>
 #include <zmk/split/bluetooth/uuid.h>
 #include <zmk/split/bluetooth/service.h>
@@ -874,10 +875,10 @@ int zmk_split_bt_update_hid_indicator(zmk_hid_indicators_t indicators) {
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
-static uint32_t layers_for_peripheral = 0;
+static zmk_keymap_layers_state_t layers_for_peripheral = 0;
 
 static void split_central_update_layers_callback(struct k_work *work) {
-    uint32_t layers = layers_for_peripheral;
+    zmk_keymap_layers_state_t layers = layers_for_peripheral;
     for (int i = 0; i < ZMK_SPLIT_BLE_PERIPHERAL_COUNT; i++) {
         if (peripherals[i].state != PERIPHERAL_SLOT_STATE_CONNECTED) {
             continue;
@@ -901,7 +902,7 @@ static void split_central_update_layers_callback(struct k_work *work) {
 
 static K_WORK_DEFINE(split_central_update_layers, split_central_update_layers_callback);
 
-int zmk_split_bt_update_layers(uint32_t new_layers) {
+int zmk_split_bt_update_layers(zmk_keymap_layers_state_t new_layers) {
     layers_for_peripheral = new_layers;
     return k_work_submit_to_queue(&split_central_split_run_q, &split_central_update_layers);
 }
@@ -3,13 +3,20 @@
 #include <zephyr/sys/util.h>
 
 #include <zmk/split/bluetooth/peripheral_layers.h>
+#include <zmk/events/layer_state_changed.h>
 
-static uint32_t peripheral_layers = 0;
+static zmk_keymap_layers_state_t peripheral_layers = 0;
+
+void set_peripheral_layers_state(zmk_keymap_layers_state_t new_layers) {
+    zmk_keymap_layers_state_t old_layers = peripheral_layers;
 
-void set_peripheral_layers_state(uint32_t new_layers) {
     peripheral_layers = new_layers;
+
+    if (old_layers != new_layers) {
+        raise_layer_state_changed(old_layers, new_layers);
+    }
 }
 
 bool peripheral_layer_active(uint8_t layer) {
-    return (peripheral_layers & (BIT(layer))) == (BIT(layer));
+    return (peripheral_layers & ZMK_KEYMAP_LAYER_BIT(layer)) != 0;
 };
\ No newline at end of file
@@ -139,10 +139,10 @@ static ssize_t split_svc_update_indicators(struct bt_conn *conn, const struct bt
 
 #endif // IS_ENABLED(CONFIG_ZMK_SPLIT_PERIPHERAL_HID_INDICATORS)
 
-static uint32_t layers = 0;
+static zmk_keymap_layers_state_t layers = 0;
 
 static void split_svc_update_layers_callback(struct k_work *work) {
-    LOG_DBG("Setting peripheral layers: %x", layers);
+    LOG_DBG("Setting peripheral layers: %llx", (unsigned long long)layers);
     set_peripheral_layers_state(layers);
 }
 
@@ -151,7 +151,7 @@ static K_WORK_DEFINE(split_svc_update_layers_work, split_svc_update_layers_callb
 static ssize_t split_svc_update_layers(struct bt_conn *conn, const struct bt_gatt_attr *attr,
                                        const void *buf, uint16_t len, uint16_t offset,
                                        uint8_t flags) {
-    if (offset + len > sizeof(uint32_t)) {
+    if (offset + len > sizeof(layers)) {
         return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
     }
 
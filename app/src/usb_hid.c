@@ -109,6 +109,15 @@ static int set_report_cb(const struct device *dev, struct usb_setup_packet *setu
         }
         break;
 #endif // IS_ENABLED(CONFIG_ZMK_HID_INDICATORS)
+#if IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
+    case ZMK_HID_REPORT_ID_KEYMAP_UPDATE:
+        // The first byte is the report ID, the rest is the zero-padded update message.
+        if (*len < 2) {
+            LOG_ERR("Keymap update report is malformed: length=%d", *len);
+            return -EINVAL;
+        }
+        return zmk_keymap_update_submit(*data + 1, *len - 1);
+#endif // IS_ENABLED(CONFIG_ZMK_KEYMAP_UPDATE_USB)
     default:
         LOG_ERR("Invalid report ID %d requested", setup->wValue & HID_GET_REPORT_ID_MASK);
         return -EINVAL;
@@ -4,64 +4,146 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include <zephyr/device.h>
-#include <zephyr/init.h>
+#include <string.h>
+
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 
 #include <zephyr/logging/log.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+#include <zmk/activity.h>
 #include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
 #include <zmk/events/wpm_state_changed.h>
 #include <zmk/events/keycode_state_changed.h>
 
 #include <zmk/wpm.h>
 
-#define WPM_UPDATE_INTERVAL_SECONDS 1
-#define WPM_RESET_INTERVAL_SECONDS 5
+#define WPM_TICK_MS CONFIG_ZMK_WPM_TICK_MS
+#define WPM_WINDOW_MS (CONFIG_ZMK_WPM_WINDOW_SECONDS * 1000)
+#define WPM_WINDOW_TICKS (WPM_WINDOW_MS / WPM_TICK_MS)
+
+BUILD_ASSERT(WPM_WINDOW_MS % WPM_TICK_MS == 0,
+             "CONFIG_ZMK_WPM_TICK_MS must divide the WPM window evenly");
 
 // See https://en.wikipedia.org/wiki/Words_per_minute
 // "Since the length or duration of words is clearly variable, for the purpose of measurement of
 // text entry, the definition of each "word" is often standardized to be five characters or
 // keystrokes long in English"
-#define CHARS_PER_WORD 5.0
+#define CHARS_PER_WORD 5
+
+// Fractional bits kept in the smoothed WPM, so that small steps aren't lost to rounding.
+#define WPM_FRACTION_BITS 8
+
+static uint8_t wpm_state;
+static int32_t wpm_smoothed;
+
+// Key releases since the last tick.
+static atomic_t keys_pending;
+// Key releases in each tick of the window. window_next is the oldest, and is replaced next.
+static uint16_t window[WPM_WINDOW_TICKS];
+static uint16_t window_next;
+static uint32_t window_keys;
+// Ticks since the meter started, up to the length of the window.
+static uint16_t window_filled;
 
-static uint8_t wpm_state = -1;
-static uint8_t last_wpm_state;
-static uint8_t wpm_update_counter;
-static uint32_t key_pressed_count;
+static atomic_t wpm_running;
 
 int zmk_wpm_get_state(void) { return wpm_state; }
 
+void wpm_expiry_function(struct k_timer *_timer);
+
+K_TIMER_DEFINE(wpm_timer, wpm_expiry_function, NULL);
+
+static void wpm_start(void) {
+    if (!atomic_set(&wpm_running, true)) {
+        k_timer_start(&wpm_timer, K_MSEC(WPM_TICK_MS), K_MSEC(WPM_TICK_MS));
+    }
+}
+
+static void wpm_stop(void) {
+    k_timer_stop(&wpm_timer);
+    window_filled = 0;
+    wpm_smoothed = 0;
+    atomic_clear(&wpm_running);
+
+    // A key released while stopping would otherwise wait for the next one to be counted.
+    if (atomic_get(&keys_pending) > 0) {
+        wpm_start();
+    }
+}
+
+// Drops the whole window and reads zero, so smoothing doesn't keep the meter ticking while idle.
+// Idle is raised from the system work queue, the same queue wpm_work runs on.
+static void wpm_reset(void) {
+    k_timer_stop(&wpm_timer);
+    atomic_clear(&keys_pending);
+    memset(window, 0, sizeof(window));
+    window_next = 0;
+    window_keys = 0;
+    window_filled = 0;
+    wpm_smoothed = 0;
+    atomic_clear(&wpm_running);
+
+    if (wpm_state != 0) {
+        LOG_DBG("Raised WPM state changed %d on idle", 0);
+
+        wpm_state = 0;
+        raise_zmk_wpm_state_changed((struct zmk_wpm_state_changed){.state = wpm_state});
+    }
+}
+
 int wpm_event_listener(const zmk_event_t *eh) {
     const struct zmk_keycode_state_changed *ev = as_zmk_keycode_state_changed(eh);
     if (ev) {
         // count only key up events
         if (!ev->state) {
-            key_pressed_count++;
-            LOG_DBG("key_pressed_count %d keycode %d", key_pressed_count, ev->keycode);
+            atomic_inc(&keys_pending);
+            LOG_DBG("keycode %d released", ev->keycode);
+            wpm_start();
         }
+        return 0;
+    }
+
+    const struct zmk_activity_state_changed *activity_ev = as_zmk_activity_state_changed(eh);
+    if (activity_ev && activity_ev->state != ZMK_ACTIVITY_ACTIVE) {
+        wpm_reset();
     }
+
     return 0;
 }
 
 void wpm_work_handler(struct k_work *work) {
-    wpm_update_counter++;
-    wpm_state = (key_pressed_count / CHARS_PER_WORD) /
-                (wpm_update_counter * WPM_UPDATE_INTERVAL_SECONDS / 60.0);
+    const uint16_t keys = atomic_clear(&keys_pending);
 
-    if (last_wpm_state != wpm_state) {
-        LOG_DBG("Raised WPM state changed %d wpm_update_counter %d", wpm_state, wpm_update_counter);
+    window_keys = window_keys - window[window_next] + keys;
+    window[window_next] = keys;
+    window_next = (window_next + 1) % WPM_WINDOW_TICKS;
+    window_filled = MIN(window_filled + 1, WPM_WINDOW_TICKS);
 
-        raise_zmk_wpm_state_changed((struct zmk_wpm_state_changed){.state = wpm_state});
+    // Until the window has filled up, average over the time since typing started instead, so the
+    // reading doesn't start out low.
+    const int32_t wpm = window_keys * 60000 / (CHARS_PER_WORD * window_filled * WPM_TICK_MS);
+
+    wpm_smoothed += ((wpm << WPM_FRACTION_BITS) - wpm_smoothed) * CONFIG_ZMK_WPM_SMOOTHING_WEIGHT /
+                    100;
+
+    const uint8_t state =
+        MIN((wpm_smoothed + BIT(WPM_FRACTION_BITS - 1)) >> WPM_FRACTION_BITS, UINT8_MAX);
 
-        last_wpm_state = wpm_state;
+    if (wpm_state != state) {
+        LOG_DBG("Raised WPM state changed %d", state);
+
+        wpm_state = state;
+        raise_zmk_wpm_state_changed((struct zmk_wpm_state_changed){.state = wpm_state});
     }
 
-    if (wpm_update_counter >= WPM_RESET_INTERVAL_SECONDS) {
-        wpm_update_counter = 0;
-        key_pressed_count = 0;
+    // Nothing typed in the whole window, and the reading has settled at zero, so there is nothing
+    // left to update until the next key press.
+    if (window_keys == 0 && wpm_state == 0) {
+        wpm_stop();
     }
 }
 
@@ -69,17 +151,6 @@ K_WORK_DEFINE(wpm_work, wpm_work_handler);
 
 void wpm_expiry_function(struct k_timer *_timer) { k_work_submit(&wpm_work); }
 
-K_TIMER_DEFINE(wpm_timer, wpm_expiry_function, NULL);
-
-static int wpm_init(void) {
-    wpm_state = 0;
-    wpm_update_counter = 0;
-    k_timer_start(&wpm_timer, K_SECONDS(WPM_UPDATE_INTERVAL_SECONDS),
-                  K_SECONDS(WPM_UPDATE_INTERVAL_SECONDS));
-    return 0;
-}
-
 ZMK_LISTENER(wpm, wpm_event_listener);
 ZMK_SUBSCRIPTION(wpm, zmk_keycode_state_changed);
-
-SYS_INIT(wpm_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+ZMK_SUBSCRIPTION(wpm, zmk_activity_state_changed);